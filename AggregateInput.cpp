@@ -7,33 +7,91 @@ AggregateInput AggregateInput::operator+(const BlobInput& input)
 	return i;
 }
 
+// Movement direction for each combination of the four direction bits.
+// Opposite directions cancel out.
+enum Direction { DirNone, DirF, DirB, DirR, DirL, DirFR, DirFL, DirBR, DirBL,
+	DirCount };
+
+static const unsigned char directionLUT[16] =
+{
+	DirNone, DirF,  DirB,  DirNone,	// -, F, B, FB
+	DirR,    DirFR, DirBR, DirR,	// R, FR, BR, FBR
+	DirL,    DirFL, DirBL, DirL,	// L, FL, BL, FBL
+	DirNone, DirF,  DirB,  DirNone	// RL, FRL, BRL, FBRL
+};
+
 AggregateInput& AggregateInput::operator+=(const BlobInput& input)
 {
-	BlobInput ZDir = (BlobInput)(
-		(((input & Forward) == 0) == ((input & Backward) == 0)) ? NoInput :
-		input & (Forward | Backward));
-	BlobInput XDir = (BlobInput)(
-		(((input & Right) == 0) == ((input & Left) == 0)) ? NoInput :
-		input & (Left | Right));
-	if (ZDir == Forward && XDir == NoInput)
-		FCount++;
-	else if (ZDir == Backward && XDir == NoInput)
-		BCount++;
-	else if (XDir == Right && ZDir == NoInput)
-		RCount++;
-	else if (XDir == Left && ZDir == NoInput)
-		LCount++;
-	else if (ZDir == Forward && XDir == Right)
-		FRCount++;
-	else if (ZDir == Forward && XDir == Left)
-		FLCount++;
-	else if (ZDir == Backward && XDir == Right)
-		BRCount++;
-	else if (ZDir == Backward && XDir == Left)
-		BLCount++;
-	if (input & Jump)
-		JCount++;
-	TotalCount++;
+	return Add(&input, 1);
+}
+
+AggregateInput& AggregateInput::Add(const BlobInput *inputs, std::size_t count)
+{
+	// Histogram over the 5-bit mask first, then fold the 32 bins
+	int bins[32] = {};
+	for (std::size_t i = 0; i < count; i++)
+		bins[inputs[i] & 0x1F]++;
+
+	int directions[DirCount] = {};
+	for (int mask = 0; mask < 32; mask++)
+	{
+		directions[directionLUT[mask & 0x0F]] += bins[mask];
+		JCount += bins[mask] * (mask >> 4);
+	}
+
+	FCount += directions[DirF];
+	BCount += directions[DirB];
+	RCount += directions[DirR];
+	LCount += directions[DirL];
+	FRCount += directions[DirFR];
+	FLCount += directions[DirFL];
+	BRCount += directions[DirBR];
+	BLCount += directions[DirBL];
+	TotalCount += (int)count;
 
 	return *this;
 }
+
+AggregateInput& AggregateInput::operator+=(const AggregateInput& other)
+{
+	FCount += other.FCount;
+	BCount += other.BCount;
+	RCount += other.RCount;
+	LCount += other.LCount;
+	FRCount += other.FRCount;
+	FLCount += other.FLCount;
+	BRCount += other.BRCount;
+	BLCount += other.BLCount;
+	JCount += other.JCount;
+	TotalCount += other.TotalCount;
+
+	return *this;
+}
+
+void AggregateInput::Write(ByteWriter& out) const
+{
+	out.PutVarUInt(FCount);
+	out.PutVarUInt(BCount);
+	out.PutVarUInt(RCount);
+	out.PutVarUInt(LCount);
+	out.PutVarUInt(FRCount);
+	out.PutVarUInt(FLCount);
+	out.PutVarUInt(BRCount);
+	out.PutVarUInt(BLCount);
+	out.PutVarUInt(JCount);
+	out.PutVarUInt(TotalCount);
+}
+
+void AggregateInput::Read(ByteReader& in)
+{
+	FCount = in.GetVarUInt();
+	BCount = in.GetVarUInt();
+	RCount = in.GetVarUInt();
+	LCount = in.GetVarUInt();
+	FRCount = in.GetVarUInt();
+	FLCount = in.GetVarUInt();
+	BRCount = in.GetVarUInt();
+	BLCount = in.GetVarUInt();
+	JCount = in.GetVarUInt();
+	TotalCount = in.GetVarUInt();
+}
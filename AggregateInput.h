@@ -1,6 +1,9 @@
 #pragma once
 
 #include "BlobInput.h"
+#include "ByteStream.h"
+
+#include <cstddef>
 
 struct AggregateInput
 {
@@ -17,4 +20,11 @@ struct AggregateInput
 
 	AggregateInput operator+(const BlobInput& input);
 	AggregateInput& operator+=(const BlobInput& input);
+	AggregateInput& operator+=(const AggregateInput& other);
+
+	// Counts one vote per element
+	AggregateInput& Add(const BlobInput *inputs, std::size_t count);
+
+	void Write(ByteWriter& out) const;
+	void Read(ByteReader& in);
 };
@@ -2,13 +2,17 @@
 #include <imgui.h>
 #include "imgui_impl_glfw.h"
 #include "Timer.h"
+#include <cmath>
 
 Blob::Blob(
 		btSoftBodyWorldInfo& softBodyWorldInfo,
-		const btVector3& center, btScalar r, int vertices) :
-	SoftBody(btSoftBodyHelpers::CreateEllipsoid(
-				softBodyWorldInfo, center, btVector3(1, 1, 1) * r, vertices)),
+		const btVector3& center, btScalar r, int vertices,
+		int renderSubdivisions, bool meshes) :
+	SoftBody(CreateSoftBody(softBodyWorldInfo, center, r, vertices), meshes),
+	spawn(center),
 	centroid(center),
+	previousCentroid(center),
+	renderCentroid(center),
 	radius(r),
 	speed(5500.f / vertices)
 {
@@ -36,6 +40,45 @@ Blob::Blob(
 		}
 	}
 
+	restPositions.resize(softbody->m_nodes.size());
+	for (int i = 0, n = softbody->m_nodes.size(); i < n; i++)
+		restPositions[i] = softbody->m_nodes[i].m_x;
+
+	if (renderSubdivisions > 0)
+	{
+		embedding = new BlobEmbedding(softbody, renderSubdivisions,
+			center, r);
+		SetIndices(embedding->Indices);
+		Upload();
+	}
+}
+
+btSoftBody* Blob::CreateSoftBody(btSoftBodyWorldInfo& softBodyWorldInfo,
+	const btVector3& center, btScalar r, int vertices, int subdivisions)
+{
+	btSoftBody *softbody = btSoftBodyHelpers::CreateEllipsoid(
+		softBodyWorldInfo, center, btVector3(1, 1, 1) * r, vertices);
+	if (subdivisions > 0)
+	{
+		// The embedding's rest shape, simulated directly
+		BlobEmbedding fine(softbody, subdivisions, center, r);
+		std::vector<glm::vec3> x(softbody->m_nodes.size()), n(x.size());
+		for (std::size_t i = 0; i < x.size(); i++)
+		{
+			x[i] = convert(softbody->m_nodes[i].m_x);
+			n[i] = glm::normalize(x[i] - convert(center));
+		}
+		std::vector<glm::vec3> fineX, fineN;
+		fine.Deform(x, n, fineX, fineN);
+		delete softbody;
+
+		std::vector<btScalar> positions;
+		for (const glm::vec3& v : fineX)
+			positions.insert(positions.end(), { v.x, v.y, v.z });
+		std::vector<int> triangles(fine.Indices.begin(), fine.Indices.end());
+		softbody = btSoftBodyHelpers::CreateFromTriMesh(softBodyWorldInfo,
+			positions.data(), triangles.data(), (int)triangles.size() / 3);
+	}
 	softbody->m_materials[0]->m_kLST = 0.1;
 	softbody->m_cfg.kDF = 1;
 	softbody->m_cfg.kDG = 0.008;
@@ -49,18 +92,66 @@ Blob::Blob(
 		btSoftBody::fCollision::CL_RS; ///Cluster vs convex rigid vs soft;
 	//class btSoftRididCollisionAlgorithm;
 	//class btSoftRigidDynamicsWorld;
-
+	return softbody;
 }
 
 Blob::~Blob()
 {
+	delete embedding;
+}
+
+void Blob::Reset()
+{
+	const btScalar margin = softbody->getCollisionShape()->getMargin();
+	ATTRIBUTE_ALIGNED16(btDbvtVolume) volume;
+	for (int i = 0, n = softbody->m_nodes.size(); i < n; i++)
+	{
+		btSoftBody::Node& node = softbody->m_nodes[i];
+		node.m_x = node.m_q = restPositions[i];
+		node.m_v = node.m_f = btVector3(0, 0, 0);
+		volume = btDbvtVolume::FromCR(node.m_x, margin);
+		softbody->m_ndbvt.update(node.m_leaf, volume);
+	}
+	softbody->updateNormals();
+	softbody->updateBounds();
+
+	forward = btVector3(0, 0, -1);
+	centroid = previousCentroid = renderCentroid = spawn;
+	previousVertices.clear();
+}
+
+void Blob::Upload()
+{
+	if (!embedding || vertices.size() != (std::size_t)softbody->m_nodes.size())
+	{
+		SoftBody::Upload();
+		return;
+	}
+	embedding->Deform(vertices, normals, renderVertices, renderNormals);
+	UploadBuffers(renderVertices, renderNormals);
+}
 
+void Blob::SaveState()
+{
+	SoftBody::SaveState();
+	previousCentroid = centroid;
 }
 
-void Blob::Update()
+void Blob::Update(float alpha)
 {
-	SoftBody::Update();
+	SoftBody::Update(alpha);
 	ComputeCentroid();
+	renderCentroid = alpha < 1.f ?
+		lerp(previousCentroid, centroid, alpha) : centroid;
+}
+
+void Blob::Update(const std::vector<glm::vec3>& previous,
+	const std::vector<glm::vec3>& current,
+	const std::vector<glm::vec3>& currentNormals,
+	const btVector3& p_centroid, float alpha)
+{
+	SoftBody::Update(previous, current, currentNormals, alpha);
+	renderCentroid = p_centroid;
 }
 
 void Blob::Move(int key, int action)
@@ -89,48 +180,79 @@ void Blob::AddForce(const btVector3 &force, int i)
 		softbody->addForce(force * speed, i);
 }
 
-void Blob::AddForces(const AggregateInput& inputs)
-{
-	float total = (float)inputs.TotalCount;
-	if (total == 0.0f)
-		total = 1.0f;
-	float magFwd = (float)inputs.FCount / total,
-		  magBack = (float)inputs.BCount / total,
-		  magRight = (float)inputs.RCount / total,
-		  magLeft = (float)inputs.LCount / total,
-		  magFR = (float)inputs.FRCount / total,
-		  magFL = (float)inputs.FLCount / total,
-		  magBR = (float)inputs.BRCount / total,
-		  magBL = (float)inputs.BLCount / total;
-	btVector3 right = forward.cross(btVector3(0, 1, 0));
-	btVector3 fwdright = (forward + right) * SIMDSQRT12;
-	btVector3 fwdleft = (forward - right) * SIMDSQRT12;
-#pragma loop(hint_parallel(0))
-#pragma loop(ivdep)
-	for (int i = 0, n = softbody->m_nodes.size(); i < n; i++)
+void Blob::AddForces(const InputMagnitudes& inputs)
+{
+	int n = softbody->m_nodes.size();
+	forceX.resize(n);
+	forceZ.resize(n);
+	float *x = forceX.data();
+	float *z = forceZ.data();
+
+	// Horizontal offsets from the centroid, as structure of arrays so the
+	// kernel below vectorises across nodes
+	const float cx = centroid.x(), cz = centroid.z();
+	for (int i = 0; i < n; i++)
 	{
-		btVector3 blobSpaceDir =
-			((softbody->m_nodes[i].m_x - centroid) *
-			 btVector3(1, 0, 1)).normalized();
-		btScalar magnitude = btMin(
-			btPow(btMax(btDot(blobSpaceDir, forward), 0.f), 2) * magFwd +
-			btPow(btMax(btDot(blobSpaceDir, -forward), 0.f), 2) * magBack +
-			btPow(btMax(btDot(blobSpaceDir, right), 0.f), 2) * magRight +
-			btPow(btMax(btDot(blobSpaceDir, -right), 0.f), 2) * magLeft +
-			btPow(btMax(btDot(blobSpaceDir, fwdright), 0.f), 2) * magFR +
-			btPow(btMax(btDot(blobSpaceDir, fwdleft), 0.f), 2) * magFL +
-			btPow(btMax(btDot(blobSpaceDir, -fwdleft), 0.f), 2) * magBR +
-			btPow(btMax(btDot(blobSpaceDir, -fwdright), 0.f), 2) * magBL,
-			1.0f);
-		btVector3 force = blobSpaceDir * magnitude;
-		AddForce(force, i);
+		x[i] = softbody->m_nodes[i].m_x.x() - cx;
+		z[i] = softbody->m_nodes[i].m_x.z() - cz;
+	}
+
+	InputForces(x, z, n, forward, inputs, speed);
+
+	// One pass of writes, skipping pinned nodes like softbody->addForce
+	for (int i = 0; i < n; i++)
+	{
+		btSoftBody::Node& node = softbody->m_nodes[i];
+		if (node.m_im > 0)
+			node.m_f += btVector3(x[i], 0, z[i]);
 	}
 
 	btScalar amplitude(0.2 / speed);
-	btScalar bounce = btSin(Timer::currentFrame) * amplitude;
+	// Not Timer, which belongs to the main thread
+	btScalar bounce = btSin(glfwGetTime()) * amplitude;
 	AddForce(btVector3(0, bounce, 0));
 }
 
+void Blob::InputForces(float *x, float *z, int n,
+	const btVector3& forward, const InputMagnitudes& inputs, float speed)
+{
+	// right = forward x up, and the diagonals between them
+	const float fx = forward.x(), fz = forward.z();
+	const float rx = -fz, rz = fx;
+	const float frx = (fx + rx) * SIMDSQRT12, frz = (fz + rz) * SIMDSQRT12;
+	const float flx = (fx - rx) * SIMDSQRT12, flz = (fz - rz) * SIMDSQRT12;
+	const float magFwd = inputs.Forward, magBack = inputs.Backward,
+		magRight = inputs.Right, magLeft = inputs.Left,
+		magFR = inputs.ForwardRight, magFL = inputs.ForwardLeft,
+		magBR = inputs.BackwardRight, magBL = inputs.BackwardLeft;
+
+	// Opposite directions share one dot product, since
+	// max(d, 0)^2 a + max(-d, 0)^2 b == d^2 (d > 0 ? a : b)
+#pragma loop(hint_parallel(0))
+#pragma loop(ivdep)
+#pragma GCC ivdep
+	for (int i = 0; i < n; i++)
+	{
+		// A zero offset stays zero whatever it is divided by, and guarding
+		// the operand rather than the sqrt keeps the loop branch free
+		float len2 = x[i] * x[i] + z[i] * z[i];
+		float inv = 1.f / std::sqrt(len2 > 0.f ? len2 : 1.f);
+		float ux = x[i] * inv, uz = z[i] * inv;
+		float dFwd = ux * fx + uz * fz;
+		float dRight = ux * rx + uz * rz;
+		float dFR = ux * frx + uz * frz;
+		float dFL = ux * flx + uz * flz;
+		float magnitude =
+			dFwd * dFwd * (dFwd > 0.f ? magFwd : magBack) +
+			dRight * dRight * (dRight > 0.f ? magRight : magLeft) +
+			dFR * dFR * (dFR > 0.f ? magFR : magBL) +
+			dFL * dFL * (dFL > 0.f ? magFL : magBR);
+		magnitude = std::min(magnitude, 1.f) * speed;
+		x[i] = ux * magnitude;
+		z[i] = uz * magnitude;
+	}
+}
+
 void Blob::ComputeCentroid()
 {
 	centroid = btVector3(0, 0, 0);
@@ -144,6 +266,16 @@ btVector3 Blob::GetCentroid()
 	return centroid;
 }
 
+btVector3 Blob::GetPreviousCentroid()
+{
+	return previousCentroid;
+}
+
+btVector3 Blob::GetRenderCentroid()
+{
+	return renderCentroid;
+}
+
 void Blob::DrawGizmos(ShaderProgram* shaderProgram)
 {
 	glm::vec3 L = convert(forward.rotate(btVector3(0, 1, 0), -glm::quarter_pi<float>()));
@@ -7,18 +7,37 @@
 #include <algorithm>
 #include <sstream>
 
-#include "AggregateInput.h"
+#include "InputWindow.h"
+#include "BlobEmbedding.h"
 #include "Line.h"
 #include "Helper.h"
 #include "ShaderProgram.h"
+#include "config.h"
 
 class Blob : public SoftBody
 {
 
 private:
 	btSoftBody::Node *sampleNodes[6] = { NULL };
+	// Node positions as created, to respawn from
+	std::vector<btVector3> restPositions;
+	btVector3 spawn;
 	btVector3 centroid;
+	btVector3 previousCentroid;
+	// What the renderer sees, which can lag or lead the simulation
+	btVector3 renderCentroid;
 	btScalar radius;
+	// Scratch for AddForces, one entry per node
+	std::vector<float> forceX;
+	std::vector<float> forceZ;
+
+	// Finer mesh drawn in place of the simulated one, if any
+	BlobEmbedding *embedding = nullptr;
+	std::vector<glm::vec3> renderVertices;
+	std::vector<glm::vec3> renderNormals;
+
+protected:
+	void Upload();
 
 public:
 	btVector3 forward;
@@ -26,18 +45,43 @@ public:
 
 	Blob(
 			btSoftBodyWorldInfo& softBodyWorldInfo,
-			const btVector3& center, btScalar scale, int vertices);
+			const btVector3& center, btScalar scale, int vertices,
+			int renderSubdivisions = BLOB_RENDER_SUBDIVISIONS,
+			bool meshes = true);
 	~Blob();
 
-	void Update();
+	// The simulated body alone, tuned like the blob's, without anything
+	// for drawing. Subdivisions simulate the finer mesh an embedding
+	// would only draw.
+	static btSoftBody* CreateSoftBody(btSoftBodyWorldInfo& softBodyWorldInfo,
+		const btVector3& center, btScalar r, int vertices,
+		int subdivisions = 0);
+
+	// Puts the nodes back where they were created, at rest. Keeps the
+	// body, its tuning and the GL buffers.
+	void Reset();
+
+	void SaveState();
+	void Update(float alpha = 1.f);
+	void Update(const std::vector<glm::vec3>& previous,
+		const std::vector<glm::vec3>& current,
+		const std::vector<glm::vec3>& currentNormals,
+		const btVector3& centroid, float alpha);
 	void Move(int key, int action);
 
 	void AddForce(const btVector3 &force);
-	void AddForces(const AggregateInput &inputs);
+	void AddForces(const InputMagnitudes &inputs);
 	void AddForce(const btVector3 &force, int i);
+	// AddForces' kernel: takes each node's horizontal offset from the
+	// centroid in x and z and leaves its input force there, scaled by speed
+	static void InputForces(float *x, float *z, int n,
+		const btVector3& forward, const InputMagnitudes& inputs,
+		float speed);
 
 	void ComputeCentroid();
 	btVector3 GetCentroid();
+	btVector3 GetPreviousCentroid();
+	btVector3 GetRenderCentroid();
 
 	void DrawGizmos(ShaderProgram* shaderProgram);
 	void Gui();
@@ -13,19 +13,17 @@ BlobDisplay::BlobDisplay(
 			-1.25f, ((float)viewportHeight / (float)displaySize) - 1.25f);
 }
 
-void BlobDisplay::Render(const ShaderProgram& program, AggregateInput& inputs)
+void BlobDisplay::Render(
+		const ShaderProgram& program, const InputMagnitudes& inputs)
 {
-	float total = (float)inputs.TotalCount;
-	if (total == 0.0f)
-		total = 1.0f;
-	program["uFMagnitude"] = (float)inputs.FCount / total;
-	program["uBMagnitude"] = (float)inputs.BCount / total;
-	program["uRMagnitude"] = (float)inputs.RCount / total;
-	program["uLMagnitude"] = (float)inputs.LCount / total;
-	program["uFRMagnitude"] = (float)inputs.FRCount / total;
-	program["uFLMagnitude"] = (float)inputs.FLCount / total;
-	program["uBRMagnitude"] = (float)inputs.BRCount / total;
-	program["uBLMagnitude"] = (float)inputs.BLCount / total;
+	program["uFMagnitude"] = inputs.Forward;
+	program["uBMagnitude"] = inputs.Backward;
+	program["uRMagnitude"] = inputs.Right;
+	program["uLMagnitude"] = inputs.Left;
+	program["uFRMagnitude"] = inputs.ForwardRight;
+	program["uFLMagnitude"] = inputs.ForwardLeft;
+	program["uBRMagnitude"] = inputs.BackwardRight;
+	program["uBLMagnitude"] = inputs.BackwardLeft;
 	program["uMVPMatrix"] = MVPMatrix;
 	program["uInnerRadius"] = InnerRadius;
 	program["uOuterRadius"] = OuterRadius;
@@ -3,7 +3,7 @@
 #include "VertexArray.h"
 #include "Buffer.h"
 #include "ShaderProgram.h"
-#include "AggregateInput.h"
+#include "InputWindow.h"
 #include <glm/glm.hpp>
 
 class BlobDisplay
@@ -16,5 +16,5 @@ class BlobDisplay
 		float OuterRadius = 0.9f;
 
 		BlobDisplay(int viewportWidth, int viewportHeight, int displaySize);
-		void Render(const ShaderProgram& program, AggregateInput& inputs);
+		void Render(const ShaderProgram& program, const InputMagnitudes& inputs);
 };
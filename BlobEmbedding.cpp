@@ -0,0 +1,111 @@
+#include "BlobEmbedding.h"
+#include "Helper.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+BlobEmbedding::BlobEmbedding(btSoftBody *coarse, int subdivisions,
+	const btVector3& center, btScalar radius)
+{
+	const int s = 1 << subdivisions;
+	const btSoftBody::Node *base = &coarse->m_nodes[0];
+
+	// Points on shared edges and corners are made once, so neighbouring
+	// faces deform them identically and no cracks open up. The key is the
+	// sorted (node, weight numerator) pairs that are non-zero.
+	std::map<std::vector<int>, int> made;
+	std::vector<int> local((s + 1) * (s + 1));
+	for (int f = 0, nf = coarse->m_faces.size(); f < nf; f++)
+	{
+		const btSoftBody::Face& face = coarse->m_faces[f];
+		int nodes[3] = {
+			(int)(face.m_n[0] - base),
+			(int)(face.m_n[1] - base),
+			(int)(face.m_n[2] - base) };
+
+		for (int j = 0; j <= s; j++)
+			for (int i = 0; i + j <= s; i++)
+			{
+				int numerators[3] = { s - i - j, i, j };
+				std::vector<std::pair<int, int>> pairs;
+				for (int k = 0; k < 3; k++)
+					if (numerators[k] > 0)
+						pairs.push_back(std::make_pair(nodes[k], numerators[k]));
+				std::sort(pairs.begin(), pairs.end());
+				std::vector<int> key;
+				for (auto& p : pairs)
+				{
+					key.push_back(p.first);
+					key.push_back(p.second);
+				}
+
+				auto found = made.find(key);
+				if (found != made.end())
+				{
+					local[j * (s + 1) + i] = found->second;
+					continue;
+				}
+
+				float w[3];
+				btVector3 rest(0, 0, 0), restNormal(0, 0, 0);
+				for (int k = 0; k < 3; k++)
+				{
+					w[k] = numerators[k] / (float)s;
+					const btVector3& x = coarse->m_nodes[nodes[k]].m_x;
+					rest += x * w[k];
+					restNormal += (x - center).normalized() * w[k];
+				}
+				restNormal.normalize();
+				btVector3 target = center + (rest - center).normalized()
+					* radius;
+
+				int index = (int)height.size();
+				node0.push_back(nodes[0]);
+				node1.push_back(nodes[1]);
+				node2.push_back(nodes[2]);
+				weight0.push_back(w[0]);
+				weight1.push_back(w[1]);
+				weight2.push_back(w[2]);
+				height.push_back(btDot(target - rest, restNormal));
+				made[key] = index;
+				local[j * (s + 1) + i] = index;
+			}
+
+		for (int j = 0; j < s; j++)
+			for (int i = 0; i + j < s; i++)
+			{
+				Indices.push_back(local[j * (s + 1) + i]);
+				Indices.push_back(local[j * (s + 1) + i + 1]);
+				Indices.push_back(local[(j + 1) * (s + 1) + i]);
+				if (i + j + 1 < s)
+				{
+					Indices.push_back(local[j * (s + 1) + i + 1]);
+					Indices.push_back(local[(j + 1) * (s + 1) + i + 1]);
+					Indices.push_back(local[(j + 1) * (s + 1) + i]);
+				}
+			}
+	}
+}
+
+void BlobEmbedding::Deform(const std::vector<glm::vec3>& coarseVertices,
+	const std::vector<glm::vec3>& coarseNormals,
+	std::vector<glm::vec3>& vertices, std::vector<glm::vec3>& normals) const
+{
+	int n = (int)height.size();
+	vertices.resize(n);
+	normals.resize(n);
+	const glm::vec3 *x = coarseVertices.data();
+	const glm::vec3 *nx = coarseNormals.data();
+#pragma loop(hint_parallel(0))
+#pragma loop(ivdep)
+	for (int i = 0; i < n; i++)
+	{
+		glm::vec3 normal = nx[node0[i]] * weight0[i]
+			+ nx[node1[i]] * weight1[i] + nx[node2[i]] * weight2[i];
+		float len2 = glm::dot(normal, normal);
+		normal *= len2 > 0.f ? 1.f / std::sqrt(len2) : 0.f;
+		normals[i] = normal;
+		vertices[i] = x[node0[i]] * weight0[i] + x[node1[i]] * weight1[i]
+			+ x[node2[i]] * weight2[i] + normal * height[i];
+	}
+}
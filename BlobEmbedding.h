@@ -0,0 +1,32 @@
+#pragma once
+
+#include <BulletSoftBody/btSoftBody.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// A finer render mesh embedded in the coarse simulated one. Each coarse
+// face is subdivided, and every fine vertex keeps three coarse nodes,
+// barycentric weights and a height along the interpolated normal that puts
+// it back on the sphere at rest. Deforming is then one pass of weighted
+// sums over arrays, whatever the fine vertex count.
+class BlobEmbedding
+{
+	public:
+		BlobEmbedding(btSoftBody *coarse, int subdivisions,
+			const btVector3& center, btScalar radius);
+
+		void Deform(const std::vector<glm::vec3>& coarseVertices,
+			const std::vector<glm::vec3>& coarseNormals,
+			std::vector<glm::vec3>& vertices,
+			std::vector<glm::vec3>& normals) const;
+
+		std::size_t Size() const { return height.size(); }
+
+		std::vector<unsigned int> Indices;
+
+	private:
+		// One entry per fine vertex
+		std::vector<int> node0, node1, node2;
+		std::vector<float> weight0, weight1, weight2;
+		std::vector<float> height;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+class ByteWriter
+{
+	public:
+		std::vector<uint8_t> Data;
+
+		void PutByte(uint8_t v) { Data.push_back(v); }
+
+		void PutVarUInt(uint32_t v)
+		{
+			while (v >= 0x80)
+			{
+				Data.push_back((uint8_t)(v | 0x80));
+				v >>= 7;
+			}
+			Data.push_back((uint8_t)v);
+		}
+
+		// Zigzag so small negative values stay short
+		void PutVarInt(int32_t v)
+		{
+			PutVarUInt(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+		}
+
+		void PutFloat(float v)
+		{
+			uint8_t bytes[4];
+			memcpy(bytes, &v, 4);
+			Data.insert(Data.end(), bytes, bytes + 4);
+		}
+
+		void PutInt16(int16_t v)
+		{
+			Data.push_back((uint8_t)v);
+			Data.push_back((uint8_t)((uint16_t)v >> 8));
+		}
+
+		// Length first
+		void PutString(const std::string& v)
+		{
+			PutVarUInt((uint32_t)v.size());
+			Data.insert(Data.end(), v.begin(), v.end());
+		}
+};
+
+class ByteReader
+{
+	public:
+		ByteReader(const uint8_t *data, std::size_t length) :
+			data(data), end(data + length) {}
+
+		bool Good() const { return good; }
+
+		uint8_t GetByte()
+		{
+			if (data >= end)
+			{
+				good = false;
+				return 0;
+			}
+			return *data++;
+		}
+
+		uint32_t GetVarUInt()
+		{
+			uint32_t v = 0;
+			for (int shift = 0; shift < 35; shift += 7)
+			{
+				uint8_t b = GetByte();
+				v |= (uint32_t)(b & 0x7f) << shift;
+				if ((b & 0x80) == 0)
+					return v;
+			}
+			good = false;
+			return 0;
+		}
+
+		int32_t GetVarInt()
+		{
+			uint32_t v = GetVarUInt();
+			return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+		}
+
+		float GetFloat()
+		{
+			float v = 0.f;
+			if (end - data < 4)
+			{
+				good = false;
+				return v;
+			}
+			memcpy(&v, data, 4);
+			data += 4;
+			return v;
+		}
+
+		int16_t GetInt16()
+		{
+			uint16_t lo = GetByte();
+			uint16_t hi = GetByte();
+			return (int16_t)(lo | hi << 8);
+		}
+
+		// Fails on strings longer than maxLength
+		std::string GetString(std::size_t maxLength)
+		{
+			uint32_t length = GetVarUInt();
+			if (length > maxLength || (std::size_t)(end - data) < length)
+			{
+				good = false;
+				return std::string();
+			}
+			std::string v((const char *)data, length);
+			data += length;
+			return v;
+		}
+
+	private:
+		const uint8_t *data;
+		const uint8_t *end;
+		bool good = true;
+};
@@ -0,0 +1,94 @@
+#include "ChatLog.h"
+#include <algorithm>
+
+bool ChatLimiter::Allow(uint64_t client, double time)
+{
+	Expire(time);
+	auto it = buckets.find(client);
+	if (it == buckets.end())
+		it = buckets.insert({ client, { CHAT_BURST, time } }).first;
+
+	Bucket& bucket = it->second;
+	bucket.Tokens = std::min((float)CHAT_BURST,
+		bucket.Tokens + (float)((time - bucket.Last) * CHAT_RATE));
+	bucket.Last = time;
+	if (bucket.Tokens < 1.f)
+		return false;
+	bucket.Tokens -= 1.f;
+	return true;
+}
+
+void ChatLimiter::Expire(double time)
+{
+	// Once per refill time, so each sweep is paid for by that many lines
+	const double refill = CHAT_BURST / CHAT_RATE;
+	if (time - lastSweep < refill)
+		return;
+	lastSweep = time;
+	for (auto it = buckets.begin(); it != buckets.end();)
+	{
+		if (time - it->second.Last >= refill)
+			it = buckets.erase(it);
+		else
+			++it;
+	}
+}
+
+void ChatLimiter::Remove(uint64_t client)
+{
+	buckets.erase(client);
+}
+
+ChatLog::ChatLog(int capacity) :
+	lines(capacity)
+{ }
+
+bool ChatLog::Add(RakNet::RakNetGUID client, std::string line, double time)
+{
+	if (!limiter.Allow(client.g, time))
+	{
+		Throttled++;
+		return false;
+	}
+
+	// Cut at a code point boundary so a multibyte character isn't split
+	if (line.size() > CHAT_MAX_LENGTH)
+	{
+		std::size_t length = CHAT_MAX_LENGTH;
+		while (length > 0 && ((unsigned char)line[length] & 0xC0) == 0x80)
+			length--;
+		line.resize(length);
+	}
+	std::replace(line.begin(), line.end(), '\n', ' ');
+
+	if (unseen == (int)lines.size())
+		Dropped++;
+	else
+		unseen++;
+	lines[next] = std::move(line);
+	next = (next + 1) % lines.size();
+	count = std::min(count + 1, (int)lines.size());
+	return true;
+}
+
+void ChatLog::Disconnected(RakNet::RakNetGUID client)
+{
+	limiter.Remove(client.g);
+}
+
+bool ChatLog::TakeText(std::string& text)
+{
+	if (unseen == 0)
+		return false;
+	unseen = 0;
+
+	text.clear();
+	int first = (next - count + (int)lines.size()) % (int)lines.size();
+	for (int i = 0; i < count; i++)
+	{
+		if (i > 0)
+			text += '\n';
+		text += lines[(first + i) % lines.size()];
+	}
+	return true;
+}
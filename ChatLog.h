@@ -0,0 +1,63 @@
+#pragma once
+
+#include <RakNet/RakNetTypes.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "config.h"
+
+// Token bucket per client, refilled at CHAT_RATE lines per second up to
+// CHAT_BURST. Relays limit their own clients with one before forwarding.
+// A bucket idle long enough to refill is no different from a new one, so
+// those are swept out; relayed players never disconnect from the server.
+class ChatLimiter
+{
+	public:
+		// Returns false if the client is over its rate
+		bool Allow(uint64_t client, double time);
+		void Remove(uint64_t client);
+
+	private:
+		struct Bucket
+		{
+			float Tokens;
+			double Last;
+		};
+
+		void Expire(double time);
+
+		std::unordered_map<uint64_t, Bucket> buckets;
+		double lastSweep = 0.0;
+};
+
+// Last few chat lines. Each client's messages are limited by a token
+// bucket, and the text is only handed out once per change so a flood
+// costs at most one rebuild per frame.
+class ChatLog
+{
+	public:
+		ChatLog(int capacity = CHAT_LOG_LINES);
+
+		// Returns false if the client is over its rate
+		bool Add(RakNet::RakNetGUID client, std::string line, double time);
+		void Disconnected(RakNet::RakNetGUID client);
+
+		// Lines oldest first, separated by newlines, if they changed
+		// since the last call
+		bool TakeText(std::string& text);
+		int Count() const { return count; }
+
+		uint64_t Throttled = 0;
+		// Accepted lines pushed out before they were ever shown
+		uint64_t Dropped = 0;
+
+	private:
+		std::vector<std::string> lines;
+		int next = 0;
+		int count = 0;
+		int unseen = 0;
+		ChatLimiter limiter;
+};
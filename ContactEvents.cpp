@@ -0,0 +1,80 @@
+#include "ContactEvents.h"
+#include "Physics.h"
+#include "config.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Buttons are pressed by whatever can be pushed onto them, as well as by
+// the blob
+static bool Presses(GameObject *trigger, GameObject *other)
+{
+	return !trigger->trigger.bDeadly && !trigger->trigger.bLoopy
+		&& !other->rigidbody->isStaticOrKinematicObject();
+}
+
+static bool Touching(const btPersistentManifold *manifold)
+{
+	for (int i = 0, n = manifold->getNumContacts(); i < n; i++)
+		if (manifold->getContactPoint(i).getDistance() <= 0.f)
+			return true;
+	return false;
+}
+
+void ContactEvents::Touch(GameObject *ent)
+{
+	if (ent && ent->trigger.bEnabled)
+		touched.push_back(ent);
+}
+
+void ContactEvents::Update(const btSoftBody *softbody,
+	const std::vector<GameObject *>& objects)
+{
+	touched.clear();
+
+	// The blob's contacts include ghosts, which just aren't responded to
+	for (int i = 0, n = softbody->m_rcontacts.size(); i < n; i++)
+		Touch((GameObject *)
+			softbody->m_rcontacts[i].m_cti.m_colObj->getUserPointer());
+
+	btDispatcher *dispatcher = Physics::dynamicsWorld->getDispatcher();
+	for (int i = 0, n = dispatcher->getNumManifolds(); i < n; i++)
+	{
+		btPersistentManifold *manifold =
+			dispatcher->getManifoldByIndexInternal(i);
+		GameObject *a = (GameObject *)manifold->getBody0()->getUserPointer();
+		GameObject *b = (GameObject *)manifold->getBody1()->getUserPointer();
+		if (!a || !b || !Touching(manifold))
+			continue;
+		if (a->trigger.bEnabled && Presses(a, b))
+			touched.push_back(a);
+		if (b->trigger.bEnabled && Presses(b, a))
+			touched.push_back(b);
+	}
+
+	std::sort(touched.begin(), touched.end(),
+		[](GameObject *a, GameObject *b) { return a->ID < b->ID; });
+	touched.erase(std::unique(touched.begin(), touched.end()),
+		touched.end());
+
+	// Last step's set becomes previous, so current is this step's after
+	std::swap(previous, current);
+	current.clear();
+	for (GameObject *ent : touched)
+	{
+		current.push_back(ent->ID);
+		if (!ent->trigger.bTriggered)
+			ent->trigger.OnEnter();
+		else
+			ent->trigger.OnStay();
+	}
+
+	left.clear();
+	std::set_difference(previous.begin(), previous.end(),
+		current.begin(), current.end(), std::back_inserter(left));
+	if (!left.empty())
+		for (GameObject *ent : objects)
+			if (std::binary_search(left.begin(), left.end(), ent->ID)
+				&& ent->trigger.bTriggered)
+				ent->trigger.OnLeave();
+}
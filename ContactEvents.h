@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+#include <BulletSoftBody/btSoftBody.h>
+
+#include "GameObject.h"
+
+// Raises trigger Enter/Stay/Leave once per step. The set of touched
+// triggers is built in one pass over the blob's rigid contacts and the
+// dispatcher's manifolds, then diffed against the previous step's, so the
+// cost follows the number of contacts rather than triggers times contacts.
+class ContactEvents
+{
+	public:
+		// After stepping, with the world locked. Objects are the level's,
+		// to find the triggers left by ID.
+		void Update(const btSoftBody *softbody,
+			const std::vector<GameObject *>& objects);
+
+		int Touched() const { return (int)current.size(); }
+
+	private:
+		std::vector<GameObject *> touched;
+		// IDs of the triggers touched this step and last, sorted. IDs
+		// rather than pointers, since the editor may delete objects.
+		std::vector<int> current;
+		std::vector<int> previous;
+		std::vector<int> left;
+
+		void Touch(GameObject *ent);
+};
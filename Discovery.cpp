@@ -0,0 +1,70 @@
+#include "Discovery.h"
+
+#include <RakNet/MessageIdentifiers.h>
+
+#include <thread>
+#include <chrono>
+
+int ChooseHost(const std::vector<DiscoveredHost>& hosts, std::mt19937& rng)
+{
+	float total = 0.f;
+	int busiest = -1;
+	for (int i = 0; i < (int)hosts.size(); i++)
+	{
+		const HostData& host = hosts[i].Data;
+		if (host.Headroom >= DISCOVERY_MIN_HEADROOM)
+			total += 1.f / (host.Players + 1.f);
+		else if (busiest < 0 || host.Headroom > hosts[busiest].Data.Headroom)
+			busiest = i;
+	}
+	if (total <= 0.f)
+		return busiest;
+
+	float pick = std::uniform_real_distribution<float>(0.f, total)(rng);
+	int last = -1;
+	for (int i = 0; i < (int)hosts.size(); i++)
+	{
+		const HostData& host = hosts[i].Data;
+		if (host.Headroom < DISCOVERY_MIN_HEADROOM)
+			continue;
+		last = i;
+		pick -= 1.f / (host.Players + 1.f);
+		if (pick < 0.f)
+			return i;
+	}
+	// Rounding left a sliver past the end
+	return last;
+}
+
+bool Discover(RakNet::RakPeerInterface *peer, const char *address,
+	unsigned short firstPort, DiscoveredHost& chosen)
+{
+	for (int i = 0; i < DISCOVERY_PORT_RANGE; i++)
+		peer->Ping(address, firstPort + i, true);
+
+	std::vector<DiscoveredHost> hosts;
+	// Runs before GLFW is initialised
+	auto window_end = std::chrono::steady_clock::now()
+		+ std::chrono::milliseconds((int)(DISCOVERY_WINDOW * 1000));
+	while (std::chrono::steady_clock::now() < window_end)
+	{
+		RakNet::Packet *p;
+		while ((p = peer->Receive()) != nullptr)
+		{
+			const HostData *host = p->data[0] == ID_UNCONNECTED_PONG ?
+				ReadHostData(p) : nullptr;
+			if (host)
+				hosts.push_back({ p->systemAddress, *host });
+			peer->DeallocatePacket(p);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	// Seeded apart, or every client would choose alike
+	static std::mt19937 rng(std::random_device{}());
+	int i = ChooseHost(hosts, rng);
+	if (i < 0)
+		return false;
+	chosen = hosts[i];
+	return true;
+}
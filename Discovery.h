@@ -0,0 +1,29 @@
+#pragma once
+
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetTypes.h>
+
+#include <random>
+#include <vector>
+
+#include "HostData.h"
+#include "config.h"
+
+struct DiscoveredHost
+{
+	RakNet::SystemAddress Address;
+	HostData Data;
+};
+
+// Picks at random among hosts with headroom left, each weighted by one
+// over its players plus one. Adverts only refresh once a second, so always
+// taking the emptiest would send every client discovering in that second
+// to the same host. If every host is busy, the one with most headroom.
+// Returns the index in hosts, or -1 if there are none.
+int ChooseHost(const std::vector<DiscoveredHost>& hosts, std::mt19937& rng);
+
+// Servers answer pings with their load, so collect adverts from every port
+// in the range for DISCOVERY_WINDOW and choose among them. Returns false
+// if nothing answered.
+bool Discover(RakNet::RakPeerInterface *peer, const char *address,
+	unsigned short firstPort, DiscoveredHost& chosen);
@@ -0,0 +1,94 @@
+#include "FrameStamp.h"
+#include <algorithm>
+
+const uint8_t FrameStamp::UUID[16] = {
+	0xb1, 0x0b, 0xca, 0x57, 0x4a, 0x7e, 0x4c, 0x1d,
+	0x9e, 0x3f, 0x62, 0x8a, 0xd5, 0x91, 0xf7, 0x2c };
+
+static void PutUInt32(std::vector<uint8_t>& out, uint32_t v)
+{
+	out.push_back((uint8_t)(v >> 24));
+	out.push_back((uint8_t)(v >> 16));
+	out.push_back((uint8_t)(v >> 8));
+	out.push_back((uint8_t)v);
+}
+
+std::vector<uint8_t> FrameStamp::CreateNAL(uint32_t frameID,
+	uint32_t captureTime)
+{
+	std::vector<uint8_t> payload(UUID, UUID + sizeof(UUID));
+	PutUInt32(payload, frameID);
+	PutUInt32(payload, captureTime);
+
+	std::vector<uint8_t> rbsp;
+	rbsp.push_back(5); // user_data_unregistered
+	rbsp.push_back((uint8_t)payload.size());
+	rbsp.insert(rbsp.end(), payload.begin(), payload.end());
+	rbsp.push_back(0x80); // rbsp_trailing_bits
+
+	std::vector<uint8_t> nal = { 0, 0, 0, 1, 0x06 };
+	int zeros = 0;
+	for (uint8_t b : rbsp)
+	{
+		// Emulation prevention
+		if (zeros >= 2 && b <= 3)
+		{
+			nal.push_back(3);
+			zeros = 0;
+		}
+		nal.push_back(b);
+		zeros = (b == 0) ? zeros + 1 : 0;
+	}
+	return nal;
+}
+
+int FrameStamp::FirstSliceOffset(const uint8_t *data, int size)
+{
+	for (int i = 0; i + 3 < size; i++)
+	{
+		if (data[i] != 0 || data[i + 1] != 0)
+			continue;
+		int header = -1;
+		if (data[i + 2] == 1)
+			header = i + 3;
+		else if (data[i + 2] == 0 && data[i + 3] == 1)
+			header = i + 4;
+		if (header < 0 || header >= size)
+			continue;
+		int type = data[header] & 0x1f;
+		if (type == 1 || type == 5)
+			return (i > 0 && data[i - 1] == 0) ? i - 1 : i;
+	}
+	return 0;
+}
+
+bool FrameStamp::Find(const uint8_t *data, int size,
+	uint32_t& frameID, uint32_t& captureTime)
+{
+	const uint8_t *end = data + size;
+	const uint8_t *it = std::search(data, end, UUID, UUID + sizeof(UUID));
+	if (it == end)
+		return false;
+	it += sizeof(UUID);
+
+	uint8_t fields[8];
+	int n = 0, zeros = 0;
+	for (; it != end && n < 8; ++it)
+	{
+		if (zeros >= 2 && *it == 3)
+		{
+			zeros = 0;
+			continue;
+		}
+		fields[n++] = *it;
+		zeros = (*it == 0) ? zeros + 1 : 0;
+	}
+	if (n < 8)
+		return false;
+
+	frameID = (uint32_t)fields[0] << 24 | (uint32_t)fields[1] << 16 |
+		(uint32_t)fields[2] << 8 | fields[3];
+	captureTime = (uint32_t)fields[4] << 24 | (uint32_t)fields[5] << 16 |
+		(uint32_t)fields[6] << 8 | fields[7];
+	return true;
+}
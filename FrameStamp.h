@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Tags encoded H.264 access units with a frame ID and capture timestamp,
+// carried as an unregistered user data SEI message that decoders ignore.
+class FrameStamp
+{
+public:
+	static std::vector<uint8_t> CreateNAL(uint32_t frameID,
+		uint32_t captureTime);
+	static int FirstSliceOffset(const uint8_t *data, int size);
+	static bool Find(const uint8_t *data, int size,
+		uint32_t& frameID, uint32_t& captureTime);
+
+private:
+	static const uint8_t UUID[16];
+};
@@ -24,9 +24,6 @@ GameObject::GameObject(Mesh* p_mesh, Shape p_shapeType,
 
 	SetCollidable(p_collidable);
 
-	if(mass != 0)
-		rigidbody->setActivationState(DISABLE_DEACTIVATION);
-
 	////http://bulletphysics.org/mediawiki-1.5.8/index.php/Constraints
 	//btGeneric6DofSpring2Constraint constraint = 
 	//	new btGeneric6DofSpring2Constraint(*rigidbody,
@@ -50,39 +47,79 @@ GameObject::GameObject(Mesh* p_mesh, Shape p_shapeType,
 
 GameObject::~GameObject()
 {
+	if (ghost)
+	{
+		Physics::dynamicsWorld->removeCollisionObject(ghost);
+		delete ghost;
+	}
 	delete rigidbody;
 }
 
 glm::mat4 GameObject::GetModelMatrix()
 {
+	if (hasRenderState)
+		return renderMatrix;
 	return glm::translate(glm::mat4(1), GetTranslation())
 		* glm::toMat4(GetOrientation())
 		* glm::scale(glm::mat4(1), GetScale());
 }
 
+glm::vec4 GameObject::GetRenderColor()
+{
+	return hasRenderState ? renderColor : color;
+}
+
+void GameObject::SetRenderState(const glm::mat4& model,
+	const glm::vec4& p_color)
+{
+	renderMatrix = model;
+	renderColor = p_color;
+	hasRenderState = true;
+}
+
+void GameObject::SaveTransform()
+{
+	previousTransform = rigidbody->getWorldTransform();
+	hasPreviousTransform = true;
+}
+
 void GameObject::Render()
 {
 	if(drawable)
 		mesh->Draw();
 }
 
-void GameObject::Update(float deltaTime)
+void GameObject::Update()
 {
+	// The editor only moves the rigidbody
+	if (ghost)
+		ghost->setWorldTransform(rigidbody->getWorldTransform());
+
+	// Paths are stepped together beforehand, by the level
 	if (!motion.Points.empty())
 	{
-		if (motion.Enabled)
-			motion.Step();
-
-		rigidbody->applyCentralForce(convert(
-			Physics::InverseDynamics(GetTranslation(),
-				motion.GetPosition(),
-				convert(rigidbody->getLinearVelocity()),
-				mass, deltaTime)));
+		// Bullet takes the velocity for contacts from how far the motion
+		// state moves over the step. The rotation is whatever the editor
+		// left on the body.
+		btTransform target(rigidbody->getWorldTransform().getRotation(),
+			convert(motion.GetPosition()));
+		btTransform current;
+		rigidbody->getMotionState()->getWorldTransform(current);
+		if (!(target == current))
+		{
+			rigidbody->getMotionState()->setWorldTransform(target);
+			// Kinematic bodies only wake when forced, and asleep they
+			// aren't moved
+			rigidbody->activate(true);
+		}
 	}
 }
 
 void GameObject::SetShape(Shape p_shapeType)
 {
+	bool wasGhost = IsGhost();
+	SetGhost(false);
+
 	glm::vec3 translation = GetTranslation();
 	glm::quat orientation = GetOrientation();
 	glm::vec3 scale = GetScale();
@@ -93,6 +130,64 @@ void GameObject::SetShape(Shape p_shapeType)
 	
 	SetShape(translation, orientation, scale,
 		p_shapeType);
+	SetGhost(wasGhost);
+}
+
+void GameObject::ConfigureBody()
+{
+	bool kinematic = !motion.Points.empty();
+	btVector3 inertia(0, 0, 0);
+	if (!kinematic)
+		rigidbody->getCollisionShape()->calculateLocalInertia(mass, inertia);
+	// Sets or clears the static flag by the mass, so read the flags after
+	rigidbody->setMassProps(kinematic ? 0 : mass, inertia);
+	int flags = rigidbody->getCollisionFlags()
+		& ~btCollisionObject::CF_KINEMATIC_OBJECT;
+	if (kinematic)
+	{
+		// A static flag left on would have Bullet never move it
+		flags = (flags & ~btCollisionObject::CF_STATIC_OBJECT)
+			| btCollisionObject::CF_KINEMATIC_OBJECT;
+		rigidbody->setLinearVelocity(btVector3(0, 0, 0));
+		rigidbody->setAngularVelocity(btVector3(0, 0, 0));
+	}
+	rigidbody->setCollisionFlags(flags);
+	rigidbody->updateInertiaTensor();
+}
+
+void GameObject::UpdateBody()
+{
+	// The world files bodies by whether they're static, kinematic or dynamic
+	if (!ghost)
+		Physics::dynamicsWorld->removeRigidBody(rigidbody);
+	ConfigureBody();
+	if (!ghost)
+		Physics::dynamicsWorld->addRigidBody(rigidbody);
+}
+
+void GameObject::SetGhost(bool set)
+{
+	if (set == IsGhost())
+		return;
+
+	if (set)
+	{
+		Physics::dynamicsWorld->removeRigidBody(rigidbody);
+		ghost = new btGhostObject();
+		ghost->setCollisionShape(rigidbody->getCollisionShape());
+		ghost->setWorldTransform(rigidbody->getWorldTransform());
+		ghost->setCollisionFlags(ghost->getCollisionFlags()
+			| btCollisionObject::CF_NO_CONTACT_RESPONSE);
+		ghost->setUserPointer(this);
+		Physics::dynamicsWorld->addCollisionObject(ghost);
+	}
+	else
+	{
+		Physics::dynamicsWorld->removeCollisionObject(ghost);
+		delete ghost;
+		ghost = nullptr;
+		Physics::dynamicsWorld->addRigidBody(rigidbody);
+	}
 }
 
 void GameObject::SetShape(glm::vec3 translation, glm::quat orientation,
@@ -115,10 +210,7 @@ void GameObject::SetShape(glm::vec3 translation, glm::quat orientation,
 		groundRigidBodyCI(mass, transform, shape, inertia);
 	
 	rigidbody = new btRigidBody(groundRigidBodyCI);
-	if (motion.Points.size() > 0)
-		rigidbody->setMassProps(mass, btVector3(0, 0, 0));
-	else
-		rigidbody->setMassProps(mass, inertia);
+	ConfigureBody();
 	rigidbody->setUserPointer(this);
 	Physics::dynamicsWorld->addRigidBody(rigidbody);
 	
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <btBulletDynamicsCommon.h>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
 #include "Mesh.h" 
 #include "Path.h"
 #include <glm/gtc/type_ptr.hpp>
@@ -23,11 +24,23 @@ private:
 
 	float mass;
 
+	btTransform previousTransform;
+	bool hasPreviousTransform = false;
+
+	// Set from simulation snapshots so rendering never touches the
+	// rigidbody while the simulation thread steps it
+	glm::mat4 renderMatrix;
+	glm::vec4 renderColor;
+	bool hasRenderState = false;
+
 public:
 
 	static int nextID;
 
 	btRigidBody* rigidbody;
+	// Stands in for the rigidbody in the world when set, so a trigger can
+	// be touched without being collided with
+	btGhostObject* ghost = nullptr;
 	
 	bool drawable = true;
 	glm::vec4 color;
@@ -62,7 +75,18 @@ public:
 			p.collidable,
 			p.motion) {}
 
+	// The render state once one is set, the rigidbody otherwise
 	glm::mat4 GetModelMatrix();
+	glm::vec4 GetRenderColor();
+	void SetRenderState(const glm::mat4& model, const glm::vec4& p_color);
+
+	// Transform before the last simulation tick
+	void SaveTransform();
+	btTransform GetPreviousTransform()
+	{
+		return hasPreviousTransform ?
+			previousTransform : rigidbody->getWorldTransform();
+	}
 
 	glm::quat GetOrientation() 
 	{
@@ -94,31 +118,32 @@ public:
 	void SetShape(Shape p_shapeType);
 	void SetMesh(Mesh* p_mesh) { mesh = p_mesh; }
 
+	bool IsGhost() { return ghost != nullptr; }
+	void SetGhost(bool set);
+
 private:
 	void SetShape(glm::vec3 translation, glm::quat orientation,
 		glm::vec3 scale, Shape p_shapeType);
 
 public:
 	void Render();
-	void Update(float deltaTime);
+	void Update();
 
 	float GetMass() { return mass; }
 
 	void SetMass(float p_mass)
 	{
-		Physics::dynamicsWorld->removeRigidBody(rigidbody);
-		btVector3 inertia;
-		rigidbody->getCollisionShape()->
-			calculateLocalInertia(p_mass, inertia);
-		
-		if (motion.Points.size() == 0)
-			rigidbody->setMassProps(p_mass, inertia);
-		else
-			rigidbody->setMassProps(p_mass, btVector3(0, 0, 0));
-
-		Physics::dynamicsWorld->addRigidBody(rigidbody);
 		mass = p_mass;
+		UpdateBody();
 	}
+
+	// After the mass changes or the path gains or loses its points
+	void UpdateBody();
+
+private:
+	// Objects with a path are kinematic and follow it; the rest are
+	// dynamic with their mass, or static without
+	void ConfigureBody();
 };
 
 
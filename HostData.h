@@ -1,9 +1,43 @@
 #pragma once
 
+#include <RakNet/RakNetTypes.h>
+#include <RakNet/RakNetTime.h>
+#include <cstdint>
+
+// Sent as the server's offline ping response
 #pragma pack(push, 1)
 struct HostData
 {
 	char HostName[16];
 	unsigned char Port[2];
+
+	// Load, refreshed once a second
+	uint16_t Players;
+	uint16_t Relays;
+	uint16_t Connections;
+	// Share of the tick budget left unused
+	float Headroom;
+	float FrameTime;
+	float InputTime;
+	float NetworkLoad;
+	uint32_t InputPackets;
+	uint32_t DroppedInputs;
+
+	char StreamEndpoint[64];
 };
 #pragma pack(pop)
+
+// Pongs carry the ping's timestamp before the response data
+inline const HostData *ReadHostData(
+	const unsigned char *data, unsigned int length)
+{
+	const unsigned int offset = sizeof(unsigned char) + sizeof(RakNet::Time);
+	if (length < offset + sizeof(HostData))
+		return nullptr;
+	return (const HostData *)(data + offset);
+}
+
+inline const HostData *ReadHostData(const RakNet::Packet *p)
+{
+	return ReadHostData(p->data, p->length);
+}
@@ -0,0 +1,52 @@
+#include "InputRelay.h"
+#include "ByteStream.h"
+#include "PacketTypes.h"
+
+#include <chrono>
+#include <thread>
+
+InputRelay::InputRelay(RakNet::RakPeerInterface *peer,
+	NetworkThread *p_network, const RakNet::RakNetGUID& p_upstream,
+	MessageFunc p_handle) :
+	rakPeer(peer), network(p_network), upstream(p_upstream),
+	handle(p_handle)
+{ }
+
+void InputRelay::Tick()
+{
+	network->SwapMessages(messages);
+	if (handle)
+		for (const NetMessage& m : messages)
+			handle(m);
+
+	// Downstream relays are already summed in by the network thread
+	network->SwapInputs(inputs);
+	if (upstream != RakNet::UNASSIGNED_RAKNET_GUID)
+	{
+		ByteWriter summary;
+		summary.PutByte(ID_BLOB_INPUT_SUMMARY);
+		summary.PutVarUInt(tick);
+		inputs.Write(summary);
+		rakPeer->Send((const char *)summary.Data.data(), summary.Data.size(),
+			HIGH_PRIORITY, UNRELIABLE_SEQUENCED, INPUT_CHANNEL, upstream,
+			false);
+	}
+	tick++;
+}
+
+void InputRelay::Run(const std::atomic<bool>& running,
+	std::function<void()> everySecond)
+{
+	auto interval = std::chrono::microseconds(1000000 / RELAY_TICK_RATE);
+	auto next_tick = std::chrono::steady_clock::now();
+	while (running)
+	{
+		bool second = tick % RELAY_TICK_RATE == 0;
+		Tick();
+		if (second && everySecond)
+			everySecond();
+
+		next_tick += interval;
+		std::this_thread::sleep_until(next_tick);
+	}
+}
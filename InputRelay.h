@@ -0,0 +1,43 @@
+#pragma once
+
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetTypes.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "AggregateInput.h"
+#include "NetworkThread.h"
+#include "config.h"
+
+// A relay's main loop. Each tick the network thread's messages are handled,
+// then what it counted since the last tick, players and downstream relays
+// alike, goes upstream as one summary. If it hasn't counted since, the last
+// summary is resent so upstream doesn't see the players drop out.
+class InputRelay
+{
+	public:
+		typedef std::function<void(const NetMessage&)> MessageFunc;
+
+		// Summaries go to upstream, which the handler may change, and
+		// aren't sent while it's unassigned
+		InputRelay(RakNet::RakPeerInterface *peer, NetworkThread *network,
+			const RakNet::RakNetGUID& upstream, MessageFunc handle);
+
+		void Tick();
+		// Ticks at RELAY_TICK_RATE until running is cleared, calling
+		// everySecond on the first tick of each second
+		void Run(const std::atomic<bool>& running,
+			std::function<void()> everySecond = nullptr);
+
+	private:
+		RakNet::RakPeerInterface *rakPeer;
+		NetworkThread *network;
+		const RakNet::RakNetGUID& upstream;
+		MessageFunc handle;
+
+		std::vector<NetMessage> messages;
+		AggregateInput inputs;
+		uint32_t tick = 0;
+};
@@ -0,0 +1,57 @@
+#include "InputTable.h"
+
+InputTable::InputTable(int capacity) :
+	Inputs(capacity, NoInput),
+	LastSeen(capacity, 0.0),
+	Packets(capacity, 0),
+	clients(capacity)
+{
+	slots.reserve(capacity);
+}
+
+int InputTable::Acquire(RakNet::RakNetGUID client, double time, bool& added)
+{
+	auto it = slots.find(client.g);
+	added = it == slots.end();
+	if (!added)
+		return it->second;
+	if (count == (int)Inputs.size())
+		return -1;
+
+	int slot = count++;
+	slots[client.g] = slot;
+	clients[slot] = client;
+	Inputs[slot] = NoInput;
+	LastSeen[slot] = time;
+	Packets[slot] = 0;
+	return slot;
+}
+
+void InputTable::Remove(RakNet::RakNetGUID client)
+{
+	auto it = slots.find(client.g);
+	if (it != slots.end())
+		RemoveSlot(it->second);
+}
+
+void InputTable::Expire(double time, double timeout)
+{
+	for (int i = count - 1; i >= 0; i--)
+		if (time - LastSeen[i] > timeout)
+			RemoveSlot(i);
+}
+
+void InputTable::RemoveSlot(int slot)
+{
+	// Move the last client into the hole to keep the slots packed
+	int last = --count;
+	slots.erase(clients[slot].g);
+	if (slot != last)
+	{
+		clients[slot] = clients[last];
+		Inputs[slot] = Inputs[last];
+		LastSeen[slot] = LastSeen[last];
+		Packets[slot] = Packets[last];
+		slots[clients[slot].g] = slot;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <RakNet/RakNetTypes.h>
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "BlobInput.h"
+
+// Latest input of every client in a fixed number of slots. Slots are kept
+// packed at the front so a tick's votes are one contiguous array.
+class InputTable
+{
+	public:
+		InputTable(int capacity);
+
+		// Returns the client's slot, adding it with NoInput if it is new,
+		// or -1 if the table is full
+		int Acquire(RakNet::RakNetGUID client, double time, bool& added);
+		void Remove(RakNet::RakNetGUID client);
+		void Expire(double time, double timeout);
+
+		int Count() const { return count; }
+		RakNet::RakNetGUID Client(int slot) const { return clients[slot]; }
+
+		std::vector<BlobInput> Inputs;
+		std::vector<double> LastSeen;
+		// Packets received since the counts were last reset
+		std::vector<uint32_t> Packets;
+
+	private:
+		int count = 0;
+		std::vector<RakNet::RakNetGUID> clients;
+		std::unordered_map<uint64_t, int> slots;
+
+		void RemoveSlot(int slot);
+};
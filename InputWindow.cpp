@@ -0,0 +1,73 @@
+#include "InputWindow.h"
+#include <imgui.h>
+#include <cmath>
+
+static void fields(const AggregateInput& inputs, int out[10])
+{
+	out[0] = inputs.FCount;
+	out[1] = inputs.BCount;
+	out[2] = inputs.RCount;
+	out[3] = inputs.LCount;
+	out[4] = inputs.FRCount;
+	out[5] = inputs.FLCount;
+	out[6] = inputs.BRCount;
+	out[7] = inputs.BLCount;
+	out[8] = inputs.JCount;
+	out[9] = inputs.TotalCount;
+}
+
+InputWindow::InputWindow(int ticks, float decay)
+{
+	Reset(ticks, decay);
+}
+
+void InputWindow::Reset(int ticks, float d)
+{
+	history.assign(ticks < 1 ? 1 : ticks, AggregateInput());
+	next = 0;
+	decay = d;
+	// Weight the oldest tick has by the time it leaves the window
+	oldestWeight = std::pow((double)decay, (double)history.size());
+	for (int i = 0; i < FIELDS; i++)
+		sums[i] = 0.0;
+}
+
+void InputWindow::Push(const AggregateInput& inputs)
+{
+	int added[FIELDS], removed[FIELDS];
+	fields(inputs, added);
+	fields(history[next], removed);
+	for (int i = 0; i < FIELDS; i++)
+		sums[i] = sums[i] * decay + added[i] - removed[i] * oldestWeight;
+
+	history[next] = inputs;
+	next = (next + 1) % (int)history.size();
+}
+
+InputMagnitudes InputWindow::Magnitudes() const
+{
+	InputMagnitudes m;
+	double total = sums[9]; // TotalCount
+	if (total <= 1e-6)
+		return m;
+	m.Forward = (float)(sums[0] / total);
+	m.Backward = (float)(sums[1] / total);
+	m.Right = (float)(sums[2] / total);
+	m.Left = (float)(sums[3] / total);
+	m.ForwardRight = (float)(sums[4] / total);
+	m.ForwardLeft = (float)(sums[5] / total);
+	m.BackwardRight = (float)(sums[6] / total);
+	m.BackwardLeft = (float)(sums[7] / total);
+	m.Jump = (float)(sums[8] / total);
+	return m;
+}
+
+void InputWindow::Gui()
+{
+	int ticks = Ticks();
+	float d = decay;
+	bool changed = ImGui::SliderInt("Input window [ticks]", &ticks, 1, 120);
+	changed |= ImGui::SliderFloat("Input decay", &d, 0.5f, 1.0f);
+	if (changed)
+		Reset(ticks, d);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "AggregateInput.h"
+#include "config.h"
+
+// Share of the vote for each direction, in [0, 1]
+struct InputMagnitudes
+{
+	float Forward = 0.f;
+	float Backward = 0.f;
+	float Right = 0.f;
+	float Left = 0.f;
+	float ForwardRight = 0.f;
+	float ForwardLeft = 0.f;
+	float BackwardRight = 0.f;
+	float BackwardLeft = 0.f;
+	float Jump = 0.f;
+};
+
+// Votes of the last Ticks ticks, each weighted by Decay^age. The weighted
+// sums are updated incrementally: decay everything by one tick, add the
+// new tick and subtract the one falling out of the window.
+class InputWindow
+{
+public:
+	InputWindow(int ticks = INPUT_WINDOW_TICKS,
+		float decay = INPUT_WINDOW_DECAY);
+
+	void Push(const AggregateInput& inputs);
+	void Reset(int ticks, float decay);
+	InputMagnitudes Magnitudes() const;
+	void Gui();
+
+	int Ticks() const { return (int)history.size(); }
+	float Decay() const { return decay; }
+
+private:
+	enum { FIELDS = 10 };
+
+	std::vector<AggregateInput> history;
+	int next = 0;
+	float decay;
+	double oldestWeight;
+	double sums[FIELDS] = {};
+};
@@ -0,0 +1,129 @@
+#include "LatencyTracker.h"
+#include <algorithm>
+#include <imgui.h>
+
+void LatencySamples::Add(float ms)
+{
+	if (Samples.size() < LATENCY_SAMPLES)
+		Samples.push_back(ms);
+	else
+		Samples[Next] = ms;
+	Next = (Next + 1) % LATENCY_SAMPLES;
+}
+
+float LatencySamples::Percentile(float p) const
+{
+	if (Samples.empty())
+		return 0.f;
+	std::vector<float> sorted(Samples);
+	std::size_t n = std::min((std::size_t)(p * sorted.size()),
+		sorted.size() - 1);
+	std::nth_element(sorted.begin(), sorted.begin() + n, sorted.end());
+	return sorted[n];
+}
+
+LatencyTracker::FrameTimes& LatencyTracker::Frame(uint32_t frameID)
+{
+	return frames[frameID % LATENCY_FRAME_HISTORY];
+}
+
+void LatencyTracker::FrameSimulated(uint32_t frameID, double time)
+{
+	FrameTimes& f = Frame(frameID);
+	f = FrameTimes();
+	f.ID = frameID;
+	f.Simulated = time;
+}
+
+void LatencyTracker::FrameCaptured(uint32_t frameID, double time)
+{
+	FrameTimes& f = Frame(frameID);
+	if (f.ID == frameID)
+		f.Captured = time;
+}
+
+void LatencyTracker::FrameEncoded(uint32_t frameID, double time)
+{
+	FrameTimes& f = Frame(frameID);
+	if (f.ID == frameID)
+		f.Encoded = time;
+}
+
+void LatencyTracker::InputReceived(RakNet::RakNetGUID client,
+	BlobInput input, double time)
+{
+	ClientLatency& c = clients[client];
+	if (input == c.Input)
+		return;
+	c.Input = input;
+	c.InputArrival = time;
+	c.Matched = false;
+}
+
+void LatencyTracker::FrameDisplayed(RakNet::RakNetGUID client,
+	uint32_t frameID, uint32_t sinceInput, double time, double oneWayDelay)
+{
+	FrameTimes& f = Frame(frameID);
+	if (f.ID != frameID || f.Encoded < 0.0)
+		return;
+
+	ClientLatency& c = clients[client];
+	double displayed = time - oneWayDelay;
+	c.SimulationToEncode.Add((float)((f.Encoded - f.Simulated) * 1000.0));
+	c.EncodeToDisplay.Add((float)((displayed - f.Encoded) * 1000.0));
+
+	// Only the first displayed frame simulated after the input arrived
+	// shows the effect of that input
+	if (!c.Matched && c.InputArrival >= 0.0
+		&& f.Simulated >= c.InputArrival)
+	{
+		double sent = c.InputArrival - oneWayDelay;
+		c.InputToSimulation.Add((float)((f.Simulated - sent) * 1000.0));
+		c.InputToDisplay.Add((float)sinceInput);
+		c.Matched = true;
+	}
+}
+
+void LatencyTracker::Disconnected(RakNet::RakNetGUID client)
+{
+	clients.erase(client);
+}
+
+void LatencyTracker::Update(double time, std::ostream& log)
+{
+	if (time - lastLog < LATENCY_LOG_INTERVAL)
+		return;
+	lastLog = time;
+
+	for (auto& c : clients)
+	{
+		const ClientLatency& l = c.second;
+		if (l.EncodeToDisplay.Samples.empty())
+			continue;
+		log << "Latency " << c.first.ToString()
+			<< " (p50/p95/p99 ms)"
+			<< " input->sim " << l.InputToSimulation.Percentile(0.5f)
+			<< "/" << l.InputToSimulation.Percentile(0.95f)
+			<< "/" << l.InputToSimulation.Percentile(0.99f)
+			<< " sim->encode " << l.SimulationToEncode.Percentile(0.5f)
+			<< "/" << l.SimulationToEncode.Percentile(0.95f)
+			<< "/" << l.SimulationToEncode.Percentile(0.99f)
+			<< " encode->display " << l.EncodeToDisplay.Percentile(0.5f)
+			<< "/" << l.EncodeToDisplay.Percentile(0.95f)
+			<< "/" << l.EncodeToDisplay.Percentile(0.99f)
+			<< " input->display " << l.InputToDisplay.Percentile(0.5f)
+			<< "/" << l.InputToDisplay.Percentile(0.95f)
+			<< "/" << l.InputToDisplay.Percentile(0.99f)
+			<< std::endl;
+	}
+}
+
+void LatencyTracker::Gui()
+{
+	LatencySamples all;
+	for (auto& c : clients)
+		for (float s : c.second.InputToDisplay.Samples)
+			all.Add(s);
+	ImGui::Text("Input to display p50 %.1f ms | p95 %.1f ms | %d clients",
+		all.Percentile(0.5f), all.Percentile(0.95f), (int)clients.size());
+}
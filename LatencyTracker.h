@@ -0,0 +1,66 @@
+#pragma once
+
+#include <RakNet/RakNetTypes.h>
+#include <cstdint>
+#include <vector>
+#include <map>
+#include <ostream>
+
+#include "BlobInput.h"
+#include "config.h"
+
+struct LatencySamples
+{
+	std::vector<float> Samples;
+	std::size_t Next = 0;
+
+	void Add(float ms);
+	float Percentile(float p) const;
+};
+
+struct ClientLatency
+{
+	BlobInput Input = NoInput;
+	double InputArrival = -1.0;
+	bool Matched = true;
+
+	LatencySamples InputToSimulation;
+	LatencySamples SimulationToEncode;
+	LatencySamples EncodeToDisplay;
+	LatencySamples InputToDisplay;
+};
+
+// Glass-to-glass latency per client. Frames are stamped with an ID when
+// simulated, captured and encoded; clients echo the ID of each frame they
+// display along with the time since their last input change.
+class LatencyTracker
+{
+public:
+	void FrameSimulated(uint32_t frameID, double time);
+	void FrameCaptured(uint32_t frameID, double time);
+	void FrameEncoded(uint32_t frameID, double time);
+
+	void InputReceived(RakNet::RakNetGUID client, BlobInput input,
+		double time);
+	void FrameDisplayed(RakNet::RakNetGUID client, uint32_t frameID,
+		uint32_t sinceInput, double time, double oneWayDelay);
+	void Disconnected(RakNet::RakNetGUID client);
+
+	void Update(double time, std::ostream& log);
+	void Gui();
+
+private:
+	struct FrameTimes
+	{
+		uint32_t ID = 0;
+		double Simulated = -1.0;
+		double Captured = -1.0;
+		double Encoded = -1.0;
+	};
+
+	FrameTimes frames[LATENCY_FRAME_HISTORY];
+	std::map<RakNet::RakNetGUID, ClientLatency> clients;
+	double lastLog = 0.0;
+
+	FrameTimes& Frame(uint32_t frameID);
+};
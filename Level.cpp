@@ -1,11 +1,18 @@
 #include "Level.h"
 #include <json.hpp>
 #include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
 #include "Trigger.h"
 
-Level::Level()
+Level::Level(bool meshes)
 {
 	//Meshes[(size_t)None] = nullptr;
+	Meshes.fill(nullptr);
+	if (!meshes)
+		return;
 	Meshes[(size_t)Box] = Mesh::CreateCubeWithNormals();
 	Meshes[(size_t)Cylinder] = Mesh::CreateCylinderWithNormals();
 }
@@ -40,6 +47,21 @@ Level& Level::operator=(Level&& other)
 	if (this != &other)
 	{
 		Clear();
+		Name = std::move(other.Name);
+		BroadphaseType = other.BroadphaseType;
+		BakeStatics = other.BakeStatics;
+		bakedShape = other.bakedShape;
+		bakedMesh = other.bakedMesh;
+		bakedBody = other.bakedBody;
+		bakedBvhBuffer = other.bakedBvhBuffer;
+		bakedVertices = std::move(other.bakedVertices);
+		bakedIndices = std::move(other.bakedIndices);
+		bakedOwners = std::move(other.bakedOwners);
+		baked = std::move(other.baked);
+		other.bakedShape = nullptr;
+		other.bakedMesh = nullptr;
+		other.bakedBody = nullptr;
+		other.bakedBvhBuffer = nullptr;
 		Objects = std::move(other.Objects);
 		ParticleSystems = std::move(other.ParticleSystems);
 		Meshes = std::move(other.Meshes);
@@ -76,6 +98,8 @@ void Level::Delete(std::size_t index)
 
 void Level::Clear()
 {
+	DeleteBake();
+	baked.clear();
 	for (GameObject *ent : Objects)
 		delete ent;
 	Objects.clear();
@@ -101,6 +125,269 @@ GameObject* Level::Find(int id)
 	return NULL;
 }
 
+void Level::GetBounds(btVector3& aabbMin, btVector3& aabbMax)
+{
+	// The blob spawns here whatever the level
+	aabbMin = aabbMax = btVector3(0, 15, 0);
+	for (GameObject *ent : Objects)
+	{
+		btVector3 min, max;
+		ent->rigidbody->getAabb(min, max);
+		aabbMin.setMin(min);
+		aabbMax.setMax(max);
+		// Movers reach their points' extents, give or take their size
+		btVector3 half = (max - min) * 0.5f;
+		for (const glm::vec3& p : ent->motion.Points)
+		{
+			btVector3 point(p.x, p.y, p.z);
+			aabbMin.setMin(point - half);
+			aabbMax.setMax(point + half);
+		}
+	}
+	btVector3 margin(BROADPHASE_BOUNDS_MARGIN, BROADPHASE_BOUNDS_MARGIN,
+		BROADPHASE_BOUNDS_MARGIN);
+	aabbMin -= margin;
+	aabbMax += margin;
+}
+
+void Level::UseBroadphase()
+{
+	btVector3 aabbMin, aabbMax;
+	GetBounds(aabbMin, aabbMax);
+	Physics::SetBroadphase(BroadphaseType, aabbMin, aabbMax);
+}
+
+// The triangles of a box or cylinder in world space, appended
+static void Triangulate(GameObject *ent, std::vector<btScalar>& vertices,
+	std::vector<int>& indices)
+{
+	const btTransform& transform = ent->rigidbody->getWorldTransform();
+	std::vector<btVector3> corners;
+	std::vector<int> faces;
+	if (ent->shapeType == Shape::Box)
+	{
+		btVector3 half = ((btBoxShape *)ent->rigidbody->getCollisionShape())
+			->getHalfExtentsWithMargin();
+		for (int i = 0; i < 8; i++)
+			corners.push_back(btVector3(i & 1 ? half.x() : -half.x(),
+				i & 2 ? half.y() : -half.y(), i & 4 ? half.z() : -half.z()));
+		faces = { 0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,  0, 4, 5, 0, 5, 1,
+			2, 3, 7, 2, 7, 6,  0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3 };
+	}
+	else
+	{
+		// Around y, as btCylinderShape is
+		btVector3 half = ((btCylinderShape *)
+			ent->rigidbody->getCollisionShape())->getHalfExtentsWithMargin();
+		const int n = BAKE_CYLINDER_SEGMENTS;
+		for (int i = 0; i < n; i++)
+		{
+			btScalar angle = SIMD_2_PI * i / n;
+			btScalar x = btCos(angle) * half.x(), z = btSin(angle) * half.z();
+			corners.push_back(btVector3(x, -half.y(), z));
+			corners.push_back(btVector3(x, half.y(), z));
+		}
+		for (int i = 0; i < n; i++)
+		{
+			int b0 = 2 * i, t0 = b0 + 1;
+			int b1 = 2 * ((i + 1) % n), t1 = b1 + 1;
+			faces.insert(faces.end(), { b0, t0, t1, b0, t1, b1 });
+			if (i > 0 && i < n - 1)
+				faces.insert(faces.end(), { 0, b0, b1, 1, t1, t0 });
+		}
+	}
+
+	int first = (int)vertices.size() / 3;
+	for (const btVector3& corner : corners)
+	{
+		btVector3 v = transform * corner;
+		vertices.insert(vertices.end(), { v.x(), v.y(), v.z() });
+	}
+	for (int index : faces)
+		indices.push_back(first + index);
+}
+
+// FNV-1a over the triangles, and what the BVH's layout depends on
+static uint64_t HashTriangles(const std::vector<btScalar>& vertices,
+	const std::vector<int>& indices)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&hash](const void *data, std::size_t size)
+	{
+		const unsigned char *bytes = (const unsigned char *)data;
+		for (std::size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+	};
+	const int layout[] = { BT_BULLET_VERSION, (int)sizeof(btScalar),
+		(int)sizeof(void *) };
+	add(layout, sizeof(layout));
+	add(vertices.data(), vertices.size() * sizeof(btScalar));
+	add(indices.data(), indices.size() * sizeof(int));
+	return hash;
+}
+
+static std::string BvhCachePath(uint64_t hash)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bvh", (unsigned long long)hash);
+	return std::string(BakeCacheDir) + name;
+}
+
+// Bullet's in place serialisation of the BVH, behind the hash of what it
+// was built from. The BVH is left in buffer, which must outlive it.
+static btOptimizedBvh* LoadBvh(uint64_t hash, void *&buffer)
+{
+	std::ifstream f(BvhCachePath(hash), std::ios::binary);
+	uint64_t fileHash = 0;
+	uint32_t size = 0;
+	if (!f.read((char *)&fileHash, sizeof(fileHash))
+		|| !f.read((char *)&size, sizeof(size)) || fileHash != hash)
+		return nullptr;
+	buffer = btAlignedAlloc(size, 16);
+	btOptimizedBvh *bvh = nullptr;
+	if (f.read((char *)buffer, size))
+		bvh = (btOptimizedBvh *)btOptimizedBvh::deSerializeInPlace(buffer,
+			size, false);
+	if (!bvh)
+	{
+		btAlignedFree(buffer);
+		buffer = nullptr;
+	}
+	return bvh;
+}
+
+static void SaveBvh(uint64_t hash, btOptimizedBvh *bvh)
+{
+	uint32_t size = bvh->calculateSerializeBufferSize();
+	void *buffer = btAlignedAlloc(size, 16);
+	if (bvh->serializeInPlace(buffer, size, false))
+	{
+		std::ofstream f(BvhCachePath(hash), std::ios::binary);
+		f.write((const char *)&hash, sizeof(hash));
+		f.write((const char *)&size, sizeof(size));
+		f.write((const char *)buffer, size);
+	}
+	btAlignedFree(buffer);
+}
+
+void Level::Bake(bool cache)
+{
+	Unbake();
+	for (GameObject *ent : Objects)
+	{
+		if (ent->GetMass() != 0 || !ent->motion.Points.empty()
+			|| !ent->GetCollidable() || ent->trigger.bEnabled
+			|| ent->IsGhost())
+			continue;
+		Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
+		baked.push_back(ent);
+	}
+	BuildBake(cache);
+}
+
+void Level::BuildBake(bool cache)
+{
+	if (baked.empty())
+		return;
+	for (int i = 0; i < (int)baked.size(); i++)
+	{
+		Triangulate(baked[i], bakedVertices, bakedIndices);
+		bakedOwners.resize(bakedIndices.size() / 3, i);
+	}
+	bakedMesh = new btTriangleIndexVertexArray(
+		(int)bakedOwners.size(), bakedIndices.data(), 3 * sizeof(int),
+		(int)bakedVertices.size() / 3, bakedVertices.data(),
+		3 * sizeof(btScalar));
+
+	// Quantised, so the tree is small enough to cache and walk quickly
+	uint64_t hash = HashTriangles(bakedVertices, bakedIndices);
+	btOptimizedBvh *bvh = cache ? LoadBvh(hash, bakedBvhBuffer) : nullptr;
+	bakedShape = new btBvhTriangleMeshShape(bakedMesh, true, !bvh);
+	if (bvh)
+		bakedShape->setOptimizedBvh(bvh);
+	else if (cache)
+		SaveBvh(hash, bakedShape->getOptimizedBvh());
+
+	btRigidBody::btRigidBodyConstructionInfo info(0, nullptr, bakedShape);
+	info.m_friction = RB_FRICTION;
+	bakedBody = new btRigidBody(info);
+	Physics::dynamicsWorld->addRigidBody(bakedBody);
+}
+
+void Level::Unbake()
+{
+	for (GameObject *ent : baked)
+		Physics::dynamicsWorld->addRigidBody(ent->rigidbody);
+	DeleteBake();
+	baked.clear();
+}
+
+void Level::Unbake(GameObject *ent)
+{
+	auto it = std::find(baked.begin(), baked.end(), ent);
+	if (it == baked.end())
+		return;
+	// A triangle mesh can't lose triangles in place, so the rest is baked
+	// again. Not cached, as it only lasts until the editor bakes again.
+	baked.erase(it);
+	DeleteBake();
+	BuildBake(false);
+	Physics::dynamicsWorld->addRigidBody(ent->rigidbody);
+}
+
+GameObject* Level::FindBaked(const btCollisionObject *body, int triangle)
+{
+	if (body != bakedBody || triangle < 0
+		|| triangle >= (int)bakedOwners.size())
+		return NULL;
+	return baked[bakedOwners[triangle]];
+}
+
+void Level::DeleteBake()
+{
+	if (bakedBody)
+	{
+		Physics::dynamicsWorld->removeRigidBody(bakedBody);
+		delete bakedBody;
+		bakedBody = nullptr;
+	}
+	delete bakedShape;
+	bakedShape = nullptr;
+	delete bakedMesh;
+	bakedMesh = nullptr;
+	btAlignedFree(bakedBvhBuffer);
+	bakedBvhBuffer = nullptr;
+	bakedVertices.clear();
+	bakedIndices.clear();
+	bakedOwners.clear();
+}
+
+static std::string FileName(const std::string& path)
+{
+	std::size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// FNV-1a, as shape and scale are all a viewer's copy has to agree on
+uint32_t Level::Layout()
+{
+	uint32_t hash = 2166136261u;
+	auto add = [&hash](int32_t v)
+	{
+		for (int i = 0; i < 4; i++)
+			hash = (hash ^ ((uint32_t)v >> (i * 8) & 0xFF)) * 16777619u;
+	};
+	add((int32_t)Objects.size());
+	for (GameObject *ent : Objects)
+	{
+		add(ent->shapeType);
+		glm::vec3 scale = ent->GetScale();
+		for (int i = 0; i < 3; i++)
+			add((int32_t)std::lround(scale[i] * 1000.f));
+	}
+	return hash;
+}
+
 void Level::Render(GLuint uMMatrix, GLuint uColor)
 {
 	for (GameObject *ent : Objects)
@@ -110,13 +397,15 @@ void Level::Render(GLuint uMMatrix, GLuint uColor)
 		glBindTexture(GL_TEXTURE_2D, textureID);
 		
 		glUniformMatrix4fv(uMMatrix, 1, GL_FALSE, &ent->GetModelMatrix()[0][0]);
-		glUniform4fv(uColor, 1, &ent->color.r);
+		glm::vec4 color = ent->GetRenderColor();
+		glUniform4fv(uColor, 1, &color.r);
 		ent->Render();
 	}
 }
 
 void Level::Serialize(std::string file)
 {
+	Name = FileName(file);
 	std::ofstream f(file);
 	nlohmann::json objects;
 	for (GameObject *ent : Objects)
@@ -180,6 +469,10 @@ void Level::Serialize(std::string file)
 		{
 			object["loopy"] = true;
 		}
+		if (ent->IsGhost())
+		{
+			object["ghost"] = true;
+		}
 
 		object["dof"] = {
 			ent->dof[0],
@@ -195,11 +488,13 @@ void Level::Serialize(std::string file)
 	
 	nlohmann::json level;
 	level["objects"] = objects;
+	level["broadphase"] = Physics::broadphaseNames[(int)BroadphaseType];
+	level["bake"] = BakeStatics;
 	f << std::setw(2) << level << std::endl;
 	f.close();
 }
 
-Level *Level::Deserialize(std::string file)
+Level *Level::Deserialize(std::string file, bool meshes)
 {
 	std::ifstream f(file);
 	if (!f.is_open())
@@ -208,7 +503,13 @@ Level *Level::Deserialize(std::string file)
 			(std::istreambuf_iterator<char>(f)),
 			std::istreambuf_iterator<char>());
 	auto data = nlohmann::json::parse(s);
-	Level *level = new Level();
+	Level *level = new Level(meshes);
+	level->Name = FileName(file);
+	if (data["broadphase"].is_string())
+		Physics::ParseBroadphase(data["broadphase"].get<std::string>(),
+			level->BroadphaseType);
+	if (data["bake"].is_boolean())
+		level->BakeStatics = data["bake"].get<bool>();
 	for (auto object : data["objects"])
 	{
 		auto j_pos = object["position"];
@@ -260,13 +561,11 @@ Level *Level::Deserialize(std::string file)
 				ent->motion.Points.insert(
 					ent->motion.Points.end(),
 						glm::vec3(point[0], point[1], point[2]));
-			ent->rigidbody->setMassProps(ent->GetMass(),
-				btVector3(0, 0, 0));
+			ent->UpdateBody();
 		}
 		auto conns = object["conns"];
 		if (!conns.is_null())
 		{
-			std::cout << conns.size() << std::endl;
 			for (int j = 0; j < conns.size(); j++)
 				level->Objects[i]->trigger.connectionIDs.push_back(conns[j]);
 			level->Objects[i]->trigger.bEnabled = true;
@@ -281,6 +580,8 @@ Level *Level::Deserialize(std::string file)
 			level->Objects[i]->trigger.bLoopy = true;
 			level->Objects[i]->trigger.bEnabled = true;
 		}
+		if (object["ghost"].is_boolean() && object["ghost"])
+			level->Objects[i]->SetGhost(true);
 
 		if (!object["dof"].is_null())
 		{
@@ -318,15 +619,20 @@ Level *Level::Deserialize(std::string file)
 
 			if (entity->trigger.bDeadly)
 				entity->trigger.RegisterCallback([]() {
-				Physics::CreateBlob();
+				Physics::RequestBlob();
 			}, Enter);
 
 			if (entity->trigger.bLoopy)
 				entity->trigger.RegisterCallback([]() {
-				Physics::CreateBlob(glm::vec4(0, 0, 1, 1));
+				Physics::RequestBlob(glm::vec4(0, 0, 1, 1));
 			}, Enter);
 		}
 	}
 
+	// Bake under the level's own broadphase, as removing proxies from the
+	// sweep and prune ones is linear in the objects
+	level->UseBroadphase();
+	if (level->BakeStatics)
+		level->Bake();
 	return level;
 }
@@ -6,6 +6,8 @@
 #include <array>
 #include "ParticleSystem.h"
 #include "Profiler.h"
+#include "Physics.h"
+#include "PathBatch.h"
 
 class Level
 {
@@ -13,11 +15,20 @@ class Level
 		static Level* currentLevel;
 
 		std::vector<GameObject*> Objects;
+		// File it was loaded from or saved to, without its directory
+		std::string Name;
 		//std::vector<Button *> Buttons;
 		std::vector<ParticleSystem *> ParticleSystems;
 		std::array<Mesh *, SHAPE_NUMITEMS> Meshes;
+		Physics::Broadphase BroadphaseType = Physics::Broadphase::Sap;
+		// Whether loading bakes the static scenery. Against the blob,
+		// triangles collide slower than boxes, so it's only worth it where
+		// the bake bench says the broadphase saves more.
+		bool BakeStatics = false;
 
-		Level();
+		// Without meshes there's nothing to render, but no GL context is
+		// needed either, as for benches
+		Level(bool meshes = true);
 		~Level();
 		Level(const Level& other);
 		Level& operator=(const Level& other);
@@ -36,9 +47,33 @@ class Level
 		void Clear();
 		int Find(btRigidBody *r);
 		GameObject* Find(int id);
+		// Everything the level's objects and paths reach, plus a margin
+		void GetBounds(btVector3& aabbMin, btVector3& aabbMax);
+		void UseBroadphase();
+		// Merges the static scenery into one triangle mesh body, which the
+		// broadphase sees as a single proxy. Its quantised BVH is cached in
+		// BakeCacheDir, unless told otherwise. Unbaking an object gives it
+		// its own rigidbody in the world again, for editing, and rebakes
+		// the rest.
+		void Bake(bool cache = true);
+		void Unbake();
+		void Unbake(GameObject *ent);
+		bool IsBaked() const { return bakedBody != nullptr; }
+		int BakedCount() const { return (int)baked.size(); }
+		// Whether the last Bake found its BVH in the cache
+		bool BakeCached() const { return bakedBvhBuffer != nullptr; }
+		// The object a ray hit on the baked body, by triangle index
+		GameObject* FindBaked(const btCollisionObject *body, int triangle);
+		// Moves every path along a tick, before the objects update
+		void StepPaths() { paths.Step(Objects); }
+		int MoverCount() const { return paths.Count(); }
+		// Hash of each object's shape and scale, in order. State sync
+		// addresses objects by index, so it only applies between levels
+		// with the same layout.
+		uint32_t Layout();
 		void Render(GLuint uMMatrix, GLuint uColor);
 		void Serialize(std::string file);
-		static Level *Deserialize(std::string file);
+		static Level *Deserialize(std::string file, bool meshes = true);
 
 		std::size_t AddParticleSystem(glm::vec3 position)
 		{
@@ -57,4 +92,22 @@ class Level
 			}
 			Profiler::Finish("Particles", true);
 		}
+
+	private:
+		btBvhTriangleMeshShape *bakedShape = nullptr;
+		btTriangleIndexVertexArray *bakedMesh = nullptr;
+		btRigidBody *bakedBody = nullptr;
+		// World space triangles of the baked objects, which bakedMesh
+		// points into, and the index in baked of each triangle's object
+		std::vector<btScalar> bakedVertices;
+		std::vector<int> bakedIndices;
+		std::vector<int> bakedOwners;
+		// What a cached BVH was loaded into, which it lives in
+		void *bakedBvhBuffer = nullptr;
+		std::vector<GameObject *> baked;
+		PathBatch paths;
+
+		// Bakes what's in baked, from the cache if allowed
+		void BuildBake(bool cache);
+		void DeleteBake();
 };
@@ -5,6 +5,25 @@
 #include <sstream>
 #include "Timer.h"
 
+// Also remembers which triangle of the baked mesh, i.e. which baked object,
+// was hit
+struct PickCallback : public btCollisionWorld::ClosestRayResultCallback
+{
+	int Triangle = -1;
+
+	PickCallback(const btVector3& from, const btVector3& to) :
+		ClosestRayResultCallback(from, to) {}
+
+	btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult,
+		bool normalInWorldSpace)
+	{
+		Triangle = rayResult.m_localShapeInfo ?
+			rayResult.m_localShapeInfo->m_triangleIndex : -1;
+		return ClosestRayResultCallback::addSingleResult(rayResult,
+			normalInWorldSpace);
+	}
+};
+
 void LevelEditor::MainMenuBar()
 {
 	if (ImGui::BeginMainMenuBar())
@@ -22,6 +41,7 @@ void LevelEditor::MainMenuBar()
 					NULL,
 					0);
 				if (lTheOpenFileName != NULL) {
+					std::lock_guard<std::mutex> lock(Physics::worldMutex);
 					selection.clear();
 					for (GameObject* ent : Level::currentLevel->Objects)
 						Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
@@ -73,6 +93,7 @@ void LevelEditor::MainMenuBar()
 			Level* level = Level::currentLevel;
 			if (ImGui::MenuItem("GameObject"))
 			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
 				level->AddGameObject(glm::vec3(0), glm::quat(), glm::vec3(1),
 					glm::vec4(.5f, .5f, .5f, 1.f), 4, "box", 1.0f);
 				selection.clear();
@@ -88,7 +109,43 @@ void LevelEditor::MainMenuBar()
 				Physics::bStepPhysics))
 				Physics::bStepPhysics ^= 1;
 			if (ImGui::Button("Step Once"))
-				Physics::dynamicsWorld->stepSimulation(Timer::deltaTime, 10);
+				Physics::RequestStep();
+
+			// Objects are unbaked when selected. Saved with the level.
+			if (ImGui::MenuItem("Bake Static Objects", NULL,
+				Level::currentLevel->BakeStatics))
+			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
+				Level *level = Level::currentLevel;
+				level->BakeStatics = !level->BakeStatics;
+				if (level->BakeStatics)
+					level->Bake();
+				else
+					level->Unbake();
+			}
+
+			// Saved with the level
+			if (ImGui::BeginMenu("Broadphase"))
+			{
+				Level *level = Level::currentLevel;
+				for (int i = 0; i < (int)Physics::Broadphase::Count; i++)
+				{
+					if (ImGui::MenuItem(Physics::broadphaseNames[i], NULL,
+						(int)level->BroadphaseType == i))
+					{
+						std::lock_guard<std::mutex> lock(Physics::worldMutex);
+						level->BroadphaseType = (Physics::Broadphase)i;
+						level->UseBroadphase();
+					}
+				}
+				// Also refits the bounds after editing
+				if (ImGui::MenuItem("Rebuild"))
+				{
+					std::lock_guard<std::mutex> lock(Physics::worldMutex);
+					level->UseBroadphase();
+				}
+				ImGui::EndMenu();
+			}
 
 			ImGui::EndMenu();
 		}
@@ -110,6 +167,7 @@ void LevelEditor::SelectionWindow(ShaderProgram *shaderProgram)
 
 		if (ImGui::Button("Put Blob Above"))
 		{
+			std::lock_guard<std::mutex> lock(Physics::worldMutex);
 			GameObject *first = *selection.begin();
 			Physics::blob->softbody->translate(
 				convert(first->GetTranslation())
@@ -165,11 +223,15 @@ void LevelEditor::SelectionWindow(ShaderProgram *shaderProgram)
 
 			bool collidable = first->GetCollidable();
 			if (ImGui::Checkbox("Collidable", &collidable))
+			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
 				first->SetCollidable(collidable);
+			}
 			ImGui::Checkbox("Drawable", &first->drawable);
 			
 			if (ImGui::CollapsingHeader("Constraints"))
 			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
 				bool constrain= first->dof[0];
 				if (ImGui::Checkbox("freeXLin", &constrain))
 				{
@@ -278,22 +340,23 @@ void LevelEditor::SelectionWindow(ShaderProgram *shaderProgram)
 				
 			float mass = first->GetMass();
 			if (ImGui::InputFloat("Mass", &mass, 1.0f, 10.0f))
+			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
 				first->SetMass(mass);
-			if (ImGui::Button("Set Mass: Moving Platform Default"))
-				first->SetMass(MOVING_PLATFORM_MASS);
+			}
 
 			ImGui::ColorEdit4("Color", glm::value_ptr(first->trueColor));
 			
 			
-			if (first->GetMass()) {
-				if (ImGui::CollapsingHeader("Path")) {
-					Path();
-				}
+			if (ImGui::CollapsingHeader("Path")) {
+				Path();
 			}
 			
 			
 
 			if (ImGui::CollapsingHeader("Trigger")) {
+				// Callbacks run on the simulation thread
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
 				if (ImGui::Button("Set Path Link")) {
 					bSetLink = true;
 				}
@@ -308,18 +371,22 @@ void LevelEditor::SelectionWindow(ShaderProgram *shaderProgram)
 						first->trigger.bDeadly = true;
 						first->trigger.RegisterCallback(
 							[]() {
-							Physics::CreateBlob();
+							Physics::RequestBlob();
 						}, Enter);
 					}
 					if (ImGui::Button("Set Loopy")) {
 						first->trigger.bLoopy = true;
 						first->trigger.RegisterCallback(
 							[]() {
-							Physics::CreateBlob(glm::vec4(0,0,1,1));
+							Physics::RequestBlob(glm::vec4(0,0,1,1));
 						}, Enter);
 					}
 				}
 				
+				bool ghost = first->IsGhost();
+				if (ImGui::Checkbox("Ghost (touch only)", &ghost))
+					first->SetGhost(ghost);
+
 				if(first->trigger.bDeadly)
 					ImGui::Text("Deadly!");
 				else if(first->trigger.bLoopy)
@@ -355,7 +422,8 @@ void LevelEditor::Mouse(double xcursor, double ycursor, int width, int height,
 
 	glm::vec3 out_end = out_origin + out_direction * 1000.0f;
 
-	btCollisionWorld::ClosestRayResultCallback
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
+	PickCallback
 		RayCallback(btVector3(out_origin.x, out_origin.y, out_origin.z),
 			btVector3(out_end.x, out_end.y, out_end.z));
 
@@ -365,10 +433,16 @@ void LevelEditor::Mouse(double xcursor, double ycursor, int width, int height,
 
 	if (RayCallback.hasHit())
 	{
-		if (typeid(*RayCallback.m_collisionObject) != typeid(btRigidBody))
+		if (typeid(*RayCallback.m_collisionObject) != typeid(btRigidBody)
+			&& typeid(*RayCallback.m_collisionObject) != typeid(btGhostObject))
 			return;
-		NewSelection((GameObject*)RayCallback.m_collisionObject->
-			getUserPointer());
+		GameObject *ent = Level::currentLevel->FindBaked(
+			RayCallback.m_collisionObject, RayCallback.Triangle);
+		if (!ent)
+			ent = (GameObject*)RayCallback.m_collisionObject->
+				getUserPointer();
+		if (ent)
+			NewSelection(ent);
 	}
 	else
 	{
@@ -391,6 +465,7 @@ void LevelEditor::NewSelection(GameObject* newSelection)
 	{
 		if (!bCtrl)
 			ClearSelection();
+		Level::currentLevel->Unbake(newSelection);
 		newSelection->color = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
 		selection.insert(newSelection);
 	}
@@ -422,6 +497,7 @@ void LevelEditor::Translation()
 
 void LevelEditor::TranslateSelection(glm::vec3 translate)
 {
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	for (auto rb : selection)
 	{
 		rb->rigidbody->setWorldTransform(btTransform(
@@ -431,6 +507,7 @@ void LevelEditor::TranslateSelection(glm::vec3 translate)
 
 		for (int i = 0; i < rb->motion.Points.size(); i++)
 			rb->motion.Points[i] += translate;
+		rb->motion.Invalidate();
 	}
 }
 
@@ -488,6 +565,7 @@ void LevelEditor::Rotation(ShaderProgram *shaderProgram)
 
 	if (ImGui::Button("Reset Rotation"))
 	{
+		std::lock_guard<std::mutex> lock(Physics::worldMutex);
 		for (auto rb : selection)
 		{
 			rb->rigidbody->setWorldTransform(btTransform(btQuaternion(),
@@ -503,6 +581,7 @@ void LevelEditor::Rotation(ShaderProgram *shaderProgram)
 
 void LevelEditor::LocalRotation(float angle, glm::vec3 axis)
 {
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	for (auto rb : selection)
 	{
 		glm::quat orientation = glm::angleAxis(glm::radians(angle),
@@ -517,6 +596,7 @@ void LevelEditor::LocalRotation(float angle, glm::vec3 axis)
 void LevelEditor::GlobalRotation(float angle, glm::vec3 axis, 
 	glm::vec3 axisPosition)
 {
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	for (auto rb : selection)
 	{
 		glm::quat orientation = glm::angleAxis(glm::radians(angle), axis)
@@ -601,6 +681,7 @@ void LevelEditor::Scale()
 
 void LevelEditor::ScaleSelection(glm::vec3 relScale)
 {
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	for (auto rb : selection)
 	{
 		btVector3 newScale = rb->rigidbody->getCollisionShape()->
@@ -616,14 +697,20 @@ void LevelEditor::ScaleSelection(glm::vec3 relScale)
 
 void LevelEditor::Path()
 {
+	// The widgets write straight into the path the simulation steps
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	GameObject *ent = *selection.begin();
+	bool was_kinematic = !ent->motion.Points.empty();
 	ImGui::DragFloat("Speed", &ent->motion.Speed, 0.01f, 0.0f, 1.0f);
-	ImGui::Checkbox("Loop path", &ent->motion.Loop);
+	if (ImGui::Checkbox("Loop path", &ent->motion.Loop))
+		ent->motion.Invalidate();
 	ImGui::Checkbox("Enabled", &ent->motion.Enabled);
 	static int e = ent->motion.Curved;
 	ImGui::RadioButton("Straight", &e, 0);
 	ImGui::SameLine();
 	ImGui::RadioButton("Curved", &e, 1);
+	if (ent->motion.Curved != (e != 0))
+		ent->motion.Invalidate();
 	ent->motion.Curved = e;
 	ImGui::Spacing();
 	bool path_changed = false;
@@ -656,16 +743,16 @@ void LevelEditor::Path()
 	{
 		ent->motion.Points.push_back(ent->GetTranslation());
 		path_changed = true;
-
-		ent->rigidbody->setMassProps(ent->GetMass(),
-			btVector3(0, 0, 0));
 	}
 	if (path_changed)
 		ent->motion.Reset();
+	if (was_kinematic != !ent->motion.Points.empty())
+		ent->UpdateBody();
 }
 
 void LevelEditor::DeleteSelection()
 {
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	for (auto rb : selection)
 	{
 		Physics::dynamicsWorld->removeRigidBody(rb->rigidbody);
@@ -677,6 +764,7 @@ void LevelEditor::DeleteSelection()
 
 void LevelEditor::CloneSelection()
 {
+	std::lock_guard<std::mutex> lock(Physics::worldMutex);
 	for (GameObject* rb : selection)
 	{
 		GameObject* newEnt = new GameObject(*rb);
@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include "tinyfiledialogs.h"
 
+// Takes Physics::worldMutex itself around anything that changes the world,
+// so call it without the lock held
 class LevelEditor
 {
 
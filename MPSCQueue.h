@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer single-consumer queue. Each cell
+// carries a sequence number telling producers and the consumer whose
+// turn it is, so neither side ever blocks the other.
+template <class T, std::size_t N>
+class MPSCQueue
+{
+	static_assert((N & (N - 1)) == 0, "MPSCQueue size must be a power of 2");
+
+	public:
+		MPSCQueue()
+		{
+			for (std::size_t i = 0; i < N; i++)
+				cells[i].Sequence.store(i, std::memory_order_relaxed);
+		}
+		MPSCQueue(const MPSCQueue&) = delete;
+		MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+		bool Push(const T& value)
+		{
+			Cell *cell;
+			std::size_t pos = tail.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				cell = &cells[pos & (N - 1)];
+				std::size_t seq = cell->Sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+				if (diff == 0)
+				{
+					if (tail.compare_exchange_weak(
+							pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false; // Full
+				else
+					pos = tail.load(std::memory_order_relaxed);
+			}
+			cell->Value = value;
+			cell->Sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer thread only
+		bool Pop(T& value)
+		{
+			Cell& cell = cells[head & (N - 1)];
+			std::size_t seq = cell.Sequence.load(std::memory_order_acquire);
+			if ((intptr_t)seq - (intptr_t)(head + 1) < 0)
+				return false;
+			value = cell.Value;
+			cell.Sequence.store(head + N, std::memory_order_release);
+			head++;
+			return true;
+		}
+
+	private:
+		struct Cell
+		{
+			std::atomic<std::size_t> Sequence;
+			T Value;
+		};
+
+		// Padded rather than aligned, as new doesn't keep an alignas beyond
+		// 16 before C++17: the producers' tail and the consumer's head are
+		// a cache line from each other and from the cells wherever the
+		// queue lands
+		enum { CacheLine = 64 };
+		Cell cells[N];
+		char cellsPad[CacheLine];
+		std::atomic<std::size_t> tail{ 0 };
+		char tailPad[CacheLine];
+		std::size_t head = 0;
+		char headPad[CacheLine];
+};
@@ -0,0 +1,179 @@
+#include "NetStats.h"
+#include <RakNet/RakNetStatistics.h>
+#include <algorithm>
+#include <imgui.h>
+
+template <class F>
+static StatPercentiles percentiles(
+	const std::vector<ConnectionStats>& connections, F value)
+{
+	StatPercentiles p;
+	if (connections.empty())
+		return p;
+
+	std::vector<float> values(connections.size());
+	for (std::size_t i = 0; i < connections.size(); i++)
+		values[i] = value(connections[i]);
+	auto at = [&](float q) {
+		std::size_t n = std::min((std::size_t)(q * values.size()),
+			values.size() - 1);
+		std::nth_element(values.begin(), values.begin() + n, values.end());
+		return values[n];
+	};
+	p.P50 = at(0.5f);
+	p.P95 = at(0.95f);
+	p.P99 = at(0.99f);
+	return p;
+}
+
+NetStats::NetStats() :
+	log(NET_STATS_LOG),
+	clientLog(NET_STATS_CLIENT_LOG)
+{
+	log << "time,connections,ping_p50,ping_p95,ping_p99,"
+		"loss_p50,loss_p95,loss_p99,input_rate_p50,input_rate_p95,"
+		"input_rate_p99,bytes_in,bytes_out,resend_queue" << std::endl;
+	clientLog << "time,client,ping,loss,bytes_in,bytes_out,resend_queue,"
+		"input_rate" << std::endl;
+}
+
+void NetStats::Connected(
+	RakNet::RakNetGUID client, RakNet::SystemAddress address)
+{
+	if (index.count(client.g))
+		return;
+	index[client.g] = connections.size();
+	ConnectionStats c;
+	c.Client = client;
+	c.Address = address;
+	connections.push_back(c);
+}
+
+void NetStats::Disconnected(RakNet::RakNetGUID client)
+{
+	auto it = index.find(client.g);
+	if (it == index.end())
+		return;
+
+	std::size_t i = it->second;
+	index.erase(it);
+	if (i != connections.size() - 1)
+	{
+		connections[i] = connections.back();
+		index[connections[i].Client.g] = i;
+	}
+	connections.pop_back();
+}
+
+void NetStats::SetInputRates(const std::vector<InputRate>& rates)
+{
+	for (auto& c : connections)
+		c.InputRate = 0.f;
+	for (const InputRate& r : rates)
+	{
+		auto it = index.find(r.Client.g);
+		if (it != index.end())
+			connections[it->second].InputRate = r.PacketsPerSecond;
+	}
+}
+
+void NetStats::Sample(RakNet::RakPeerInterface *peer, double time, double dt)
+{
+	// Spread a full pass over the interval, capped per frame
+	sampleCredit += connections.size() * dt / NET_STATS_INTERVAL;
+	int samples = std::min((int)sampleCredit, NET_STATS_BUDGET);
+	sampleCredit = std::min(sampleCredit - samples, (double)NET_STATS_BUDGET);
+
+	RakNet::RakNetStatistics rns;
+	for (int n = 0; n < samples && !connections.empty(); n++)
+	{
+		next %= connections.size();
+		ConnectionStats& c = connections[next++];
+		if (!peer->GetStatistics(c.Address, &rns))
+			continue;
+
+		c.Sampled = time;
+		c.Ping = peer->GetAveragePing(c.Address);
+		c.Loss = rns.packetlossLastSecond;
+		c.BytesIn = rns.valueOverLastSecond[RakNet::ACTUAL_BYTES_RECEIVED];
+		c.BytesOut = rns.valueOverLastSecond[RakNet::ACTUAL_BYTES_SENT];
+		c.ResendQueue = rns.messagesInResendBuffer;
+		clientLog << time << "," << c.Client.ToString() << "," << c.Ping
+			<< "," << c.Loss << "," << c.BytesIn << "," << c.BytesOut
+			<< "," << c.ResendQueue << "," << c.InputRate << "\n";
+	}
+
+	if (time - lastSummary >= NET_STATS_INTERVAL)
+		Summarise(time);
+}
+
+void NetStats::Summarise(double time)
+{
+	lastSummary = time;
+	ping = percentiles(connections,
+		[](const ConnectionStats& c) { return (float)c.Ping; });
+	loss = percentiles(connections,
+		[](const ConnectionStats& c) { return c.Loss; });
+	inputRate = percentiles(connections,
+		[](const ConnectionStats& c) { return c.InputRate; });
+
+	bytesIn = bytesOut = resendQueue = 0;
+	for (auto& c : connections)
+	{
+		bytesIn += c.BytesIn;
+		bytesOut += c.BytesOut;
+		resendQueue += c.ResendQueue;
+	}
+
+	log << time << "," << connections.size()
+		<< "," << ping.P50 << "," << ping.P95 << "," << ping.P99
+		<< "," << loss.P50 << "," << loss.P95 << "," << loss.P99
+		<< "," << inputRate.P50 << "," << inputRate.P95
+		<< "," << inputRate.P99
+		<< "," << bytesIn << "," << bytesOut << "," << resendQueue
+		<< std::endl;
+	clientLog.flush();
+}
+
+void NetStats::Gui()
+{
+	ImGui::Text("Ping p50 %.0f ms | p95 %.0f ms | p99 %.0f ms",
+		ping.P50, ping.P95, ping.P99);
+	ImGui::Text("Loss p50 %.1f%% | p95 %.1f%% | p99 %.1f%%",
+		loss.P50 * 100.f, loss.P95 * 100.f, loss.P99 * 100.f);
+	ImGui::Text("Inputs p50 %.1f/s | p95 %.1f/s | p99 %.1f/s",
+		inputRate.P50, inputRate.P95, inputRate.P99);
+	ImGui::Text("In %.1f kB/s | Out %.1f kB/s | Resend queue %d",
+		bytesIn / 1000.0, bytesOut / 1000.0, (int)resendQueue);
+
+	if (!ImGui::CollapsingHeader("Connections"))
+		return;
+
+	// Worst connections first
+	std::vector<const ConnectionStats *> worst;
+	for (auto& c : connections)
+		worst.push_back(&c);
+	std::size_t shown = std::min(worst.size(), (std::size_t)10);
+	std::partial_sort(worst.begin(), worst.begin() + shown, worst.end(),
+		[](const ConnectionStats *a, const ConnectionStats *b) {
+			return a->Ping > b->Ping;
+		});
+
+	ImGui::Columns(5, "connections");
+	ImGui::Text("Client"); ImGui::NextColumn();
+	ImGui::Text("Ping"); ImGui::NextColumn();
+	ImGui::Text("Loss"); ImGui::NextColumn();
+	ImGui::Text("Resend"); ImGui::NextColumn();
+	ImGui::Text("Inputs/s"); ImGui::NextColumn();
+	ImGui::Separator();
+	for (std::size_t i = 0; i < shown; i++)
+	{
+		const ConnectionStats& c = *worst[i];
+		ImGui::Text("%s", c.Address.ToString()); ImGui::NextColumn();
+		ImGui::Text("%d ms", c.Ping); ImGui::NextColumn();
+		ImGui::Text("%.1f%%", c.Loss * 100.f); ImGui::NextColumn();
+		ImGui::Text("%u", c.ResendQueue); ImGui::NextColumn();
+		ImGui::Text("%.1f", c.InputRate); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+}
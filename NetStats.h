@@ -0,0 +1,64 @@
+#pragma once
+
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetTypes.h>
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+
+#include "NetworkThread.h"
+#include "config.h"
+
+struct ConnectionStats
+{
+	RakNet::RakNetGUID Client;
+	RakNet::SystemAddress Address;
+	double Sampled = -1.0;
+
+	int Ping = 0;
+	float Loss = 0.f;
+	uint64_t BytesIn = 0;
+	uint64_t BytesOut = 0;
+	unsigned int ResendQueue = 0;
+	float InputRate = 0.f;
+};
+
+struct StatPercentiles
+{
+	float P50 = 0.f;
+	float P95 = 0.f;
+	float P99 = 0.f;
+};
+
+// RakNet statistics for every connection. At most NET_STATS_BUDGET
+// connections are sampled per frame, round robin, so each is refreshed
+// about every NET_STATS_INTERVAL until there are too many to keep up.
+class NetStats
+{
+public:
+	NetStats();
+
+	void Connected(RakNet::RakNetGUID client, RakNet::SystemAddress address);
+	void Disconnected(RakNet::RakNetGUID client);
+	void SetInputRates(const std::vector<InputRate>& rates);
+
+	void Sample(RakNet::RakPeerInterface *peer, double time, double dt);
+	void Gui();
+
+private:
+	std::vector<ConnectionStats> connections;
+	std::unordered_map<uint64_t, std::size_t> index;
+	std::size_t next = 0;
+	double sampleCredit = 0.0;
+
+	double lastSummary = 0.0;
+	StatPercentiles ping, loss, inputRate;
+	uint64_t bytesIn = 0, bytesOut = 0, resendQueue = 0;
+
+	std::ofstream log;
+	std::ofstream clientLog;
+
+	void Summarise(double time);
+};
@@ -0,0 +1,208 @@
+#include "NetworkThread.h"
+#include "PacketTypes.h"
+#include <GLFW/glfw3.h>
+#include <chrono>
+
+NetworkThread::NetworkThread(RakNet::RakPeerInterface *peer) :
+	rakPeer(peer)
+{ }
+
+NetworkThread::~NetworkThread()
+{
+	Stop();
+}
+
+void NetworkThread::Start()
+{
+	running = true;
+	thread = std::thread(&NetworkThread::Run, this);
+}
+
+void NetworkThread::Stop()
+{
+	running = false;
+	if (thread.joinable())
+		thread.join();
+}
+
+bool NetworkThread::SwapInputs(AggregateInput& inputs)
+{
+	if (!ready.load(std::memory_order_acquire))
+		return false;
+	inputs = published;
+	ready.store(false, std::memory_order_release);
+	return true;
+}
+
+void NetworkThread::SwapMessages(std::vector<NetMessage>& out)
+{
+	out.clear();
+	std::lock_guard<std::mutex> lock(messageMutex);
+	std::swap(out, messages);
+}
+
+bool NetworkThread::SwapInputRates(std::vector<InputRate>& out)
+{
+	std::lock_guard<std::mutex> lock(messageMutex);
+	if (!ratesReady)
+		return false;
+	std::swap(out, inputRates);
+	ratesReady = false;
+	return true;
+}
+
+void NetworkThread::Run()
+{
+	typedef std::chrono::steady_clock clock;
+	clock::time_point second = clock::now();
+	clock::duration busy(0);
+	while (running)
+	{
+		clock::time_point start = clock::now();
+		bool received = false;
+		while (Receive())
+			received = true;
+		Accumulate();
+		clock::time_point end = clock::now();
+		busy += end - start;
+
+		if (end - second >= std::chrono::seconds(1))
+		{
+			Load = std::chrono::duration<float>(busy).count()
+				/ std::chrono::duration<float>(end - second).count();
+			busy = clock::duration(0);
+			second = end;
+		}
+
+		if (!received)
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(NET_IDLE_SLEEP_MS));
+	}
+}
+
+bool NetworkThread::Receive()
+{
+	RakNet::Packet *p = rakPeer->Receive();
+	if (p == nullptr)
+		return false;
+
+	unsigned char packet_type = p->length > 0 ? p->data[0] : 0;
+	if (packet_type == ID_BLOB_INPUT && p->length >= 2)
+	{
+		InputPackets++;
+		InputEvent e = { p->guid, (BlobInput)p->data[1] };
+		if (!Inputs.Push(e))
+			DroppedInputs++;
+	}
+	else if (packet_type == ID_BLOB_INPUT_SUMMARY)
+	{
+		ByteReader in(p->data + 1, p->length - 1);
+		uint32_t tick = in.GetVarUInt();
+		AggregateInput inputs;
+		inputs.Read(in);
+
+		// Sequenced delivery drops stale summaries. A restarted relay
+		// reconnects with a new GUID, so it starts a new entry.
+		auto it = relays.find(p->guid);
+		bool newer = it == relays.end()
+			|| (int32_t)(tick - it->second.Tick) > 0;
+		if (in.Good() && newer)
+			relays[p->guid] = { tick, inputs, glfwGetTime() };
+	}
+	else
+	{
+		double time = glfwGetTime();
+		if (packet_type == ID_DISCONNECTION_NOTIFICATION
+			|| packet_type == ID_CONNECTION_LOST)
+		{
+			// Apply anything still queued first so it can't revive the
+			// client's held input
+			Drain(time);
+			held.Remove(p->guid);
+			relays.erase(p->guid);
+		}
+
+		Post({ packet_type, p->guid, p->systemAddress, time,
+			std::vector<unsigned char>(p->data, p->data + p->length) });
+	}
+
+	rakPeer->DeallocatePacket(p);
+	return true;
+}
+
+void NetworkThread::Drain(double time)
+{
+	InputEvent e;
+	while (Inputs.Pop(e))
+	{
+		bool added;
+		int slot = held.Acquire(e.Client, time, added);
+		if (slot < 0)
+		{
+			DroppedInputs++;
+			continue;
+		}
+		bool changed = added || held.Inputs[slot] != e.Input;
+		held.Inputs[slot] = e.Input;
+		held.LastSeen[slot] = time;
+		held.Packets[slot]++;
+
+		// Input changes are forwarded for latency tracking
+		if (changed)
+			Post({ ID_BLOB_INPUT, e.Client, RakNet::UNASSIGNED_SYSTEM_ADDRESS,
+				time,
+				std::vector<unsigned char>{ ID_BLOB_INPUT, e.Input } });
+	}
+}
+
+void NetworkThread::Accumulate()
+{
+	double time = glfwGetTime();
+	Drain(time);
+
+	// Count every client's held input once, after the main thread has
+	// taken the previous tick's aggregate
+	if (!ready.load(std::memory_order_acquire))
+	{
+		held.Expire(time, INPUT_TIMEOUT);
+		published = AggregateInput();
+		published.Add(held.Inputs.data(), held.Count());
+		int relayed = 0;
+		for (auto it = relays.begin(); it != relays.end();)
+		{
+			if (time - it->second.LastSeen > INPUT_TIMEOUT)
+			{
+				it = relays.erase(it);
+				continue;
+			}
+			published += it->second.Inputs;
+			relayed += it->second.Inputs.TotalCount;
+			++it;
+		}
+		Clients = held.Count();
+		Relays = (int)relays.size();
+		RelayedPlayers = relayed;
+		ready.store(true, std::memory_order_release);
+	}
+
+	if (time - lastRates >= NET_STATS_INTERVAL)
+	{
+		std::vector<InputRate> rates(held.Count());
+		for (int i = 0; i < held.Count(); i++)
+		{
+			rates[i] = { held.Client(i),
+				(float)(held.Packets[i] / (time - lastRates)) };
+			held.Packets[i] = 0;
+		}
+		lastRates = time;
+		std::lock_guard<std::mutex> lock(messageMutex);
+		std::swap(inputRates, rates);
+		ratesReady = true;
+	}
+}
+
+void NetworkThread::Post(NetMessage&& message)
+{
+	std::lock_guard<std::mutex> lock(messageMutex);
+	messages.push_back(std::move(message));
+}
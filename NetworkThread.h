@@ -0,0 +1,104 @@
+#pragma once
+
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetTypes.h>
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <map>
+
+#include "AggregateInput.h"
+#include "MPSCQueue.h"
+#include "InputTable.h"
+#include "config.h"
+
+struct InputEvent
+{
+	RakNet::RakNetGUID Client;
+	BlobInput Input;
+};
+
+// Anything that isn't a plain input, copied out of the RakNet packet
+struct NetMessage
+{
+	unsigned char Type;
+	RakNet::RakNetGUID Client;
+	RakNet::SystemAddress Address;
+	double Time;
+	std::vector<unsigned char> Data;
+};
+
+struct InputRate
+{
+	RakNet::RakNetGUID Client;
+	float PacketsPerSecond;
+};
+
+// Receives, parses and releases packets off the main thread. Clients only
+// send input when it changes (plus a heartbeat), so inputs are pushed
+// through a lock-free queue into a table of held inputs. Each client gets
+// one vote per tick however often it sends. Relays send their own per-tick
+// counts, which are held the same way and summed in. Other messages are
+// batched for the main thread.
+class NetworkThread
+{
+	public:
+		NetworkThread(RakNet::RakPeerInterface *peer);
+		~NetworkThread();
+		NetworkThread(const NetworkThread&) = delete;
+		NetworkThread& operator=(const NetworkThread&) = delete;
+
+		void Start();
+		void Stop();
+
+		// Simulation thread. Returns false and leaves inputs alone if no
+		// tick has been counted since the last call.
+		bool SwapInputs(AggregateInput& inputs);
+		void SwapMessages(std::vector<NetMessage>& out);
+		// Returns true every NET_STATS_INTERVAL with fresh rates
+		bool SwapInputRates(std::vector<InputRate>& out);
+
+		MPSCQueue<InputEvent, NET_INPUT_QUEUE_SIZE> Inputs;
+		std::atomic<uint64_t> DroppedInputs{ 0 };
+		std::atomic<uint64_t> InputPackets{ 0 };
+		// Fraction of the last second spent receiving and counting
+		std::atomic<float> Load{ 0.f };
+		std::atomic<int> Clients{ 0 };
+		std::atomic<int> Relays{ 0 };
+		std::atomic<int> RelayedPlayers{ 0 };
+
+	private:
+		RakNet::RakPeerInterface *rakPeer;
+		std::thread thread;
+		std::atomic<bool> running{ false };
+
+		void Run();
+		bool Receive();
+		void Drain(double time);
+		void Accumulate();
+		void Post(NetMessage&& message);
+
+		struct RelaySummary
+		{
+			uint32_t Tick;
+			AggregateInput Inputs;
+			double LastSeen;
+		};
+
+		// Owned by the network thread
+		InputTable held{ INPUT_SLOTS };
+		std::map<RakNet::RakNetGUID, RelaySummary> relays;
+
+		// Owned by the network thread while ready is false, by whoever
+		// swaps inputs while it is true
+		AggregateInput published;
+		std::atomic<bool> ready{ false };
+
+		std::mutex messageMutex;
+		std::vector<NetMessage> messages;
+		std::vector<InputRate> inputRates;
+		bool ratesReady = false;
+		double lastRates = 0.0;
+};
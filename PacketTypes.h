@@ -0,0 +1,16 @@
+#pragma once
+
+#include <RakNet/MessageIdentifiers.h>
+
+enum BlobPacket : unsigned char
+{
+	ID_BLOB_INPUT = ID_USER_PACKET_ENUM,
+	ID_BLOB_CHAT,
+	ID_BLOB_FRAME_ACK,
+	ID_BLOB_STATE_SUBSCRIBE,
+	ID_BLOB_STATE,
+	ID_BLOB_INPUT_SUMMARY,
+	ID_BLOB_INPUT_SESSION,
+	// Chat forwarded by a relay: the original sender's GUID, then the text
+	ID_BLOB_RELAYED_CHAT
+};
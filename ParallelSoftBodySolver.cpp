@@ -0,0 +1,245 @@
+#include "ParallelSoftBodySolver.h"
+#include <BulletSoftBody/btSoftBodyInternals.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+ParallelSoftBodySolver::ParallelSoftBodySolver(int threads, int p_minLinks) :
+	pool(std::max(1, std::min(threads,
+		(int)std::thread::hardware_concurrency()))),
+	minLinks(p_minLinks)
+{ }
+
+void ParallelSoftBodySolver::solveConstraints(float solverdt)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < m_softBodySet.size(); i++)
+	{
+		btSoftBody *psb = m_softBodySet[i];
+		if (psb->isActive() && psb->m_nodes.size() > 0)
+			Solve(psb);
+	}
+	SolveTime = std::chrono::duration<float, std::milli>(
+		std::chrono::steady_clock::now() - start).count();
+
+	// Forget bodies that have left the world
+	for (auto it = colourings.begin(); it != colourings.end();)
+		if (m_softBodySet.findLinearSearch(it->first) == m_softBodySet.size())
+			it = colourings.erase(it);
+		else
+			++it;
+}
+
+void ParallelSoftBodySolver::ForEach(int count,
+	const WorkerPool::RangeFunc& func)
+{
+	if (!parallel)
+		func(0, count);
+	else
+		pool.Run(count, func);
+}
+
+const ParallelSoftBodySolver::Colouring&
+	ParallelSoftBodySolver::GetColouring(btSoftBody *psb)
+{
+	const btSoftBody::Node *base = &psb->m_nodes[0];
+	int links = psb->m_links.size();
+
+	// A new body can reuse a deleted one's address, so compare topology
+	Colouring& colouring = colourings[psb];
+	bool same = colouring.Nodes == psb->m_nodes.size()
+		&& (int)colouring.LinkNodes.size() == links * 2;
+	for (int i = 0; same && i < links; i++)
+		same = colouring.LinkNodes[i * 2] == psb->m_links[i].m_n[0] - base
+			&& colouring.LinkNodes[i * 2 + 1] == psb->m_links[i].m_n[1] - base;
+	if (same)
+		return colouring;
+
+	std::vector<int> linkNodes(links * 2);
+	for (int i = 0; i < links; i++)
+	{
+		linkNodes[i * 2] = (int)(psb->m_links[i].m_n[0] - base);
+		linkNodes[i * 2 + 1] = (int)(psb->m_links[i].m_n[1] - base);
+	}
+
+	// Greedy: each link takes the lowest colour free at both its nodes.
+	// Links that find none share a last colour, which is solved serially.
+	const int maxColours = 64;
+	std::vector<uint64_t> used(psb->m_nodes.size(), 0);
+	std::vector<int> colours(links);
+	std::vector<int> counts(maxColours + 1, 0);
+	for (int i = 0; i < links; i++)
+	{
+		uint64_t taken = used[linkNodes[i * 2]] | used[linkNodes[i * 2 + 1]];
+		int c = 0;
+		while (c < maxColours && (taken >> c) & 1)
+			c++;
+		if (c < maxColours)
+		{
+			used[linkNodes[i * 2]] |= (uint64_t)1 << c;
+			used[linkNodes[i * 2 + 1]] |= (uint64_t)1 << c;
+		}
+		colours[i] = c;
+		counts[c]++;
+	}
+
+	colouring.Nodes = psb->m_nodes.size();
+	colouring.LinkNodes = std::move(linkNodes);
+	colouring.Overflow = counts[maxColours] > 0;
+	colouring.Offsets.assign(1, 0);
+	for (int c = 0; c <= maxColours; c++)
+		if (counts[c] > 0)
+			colouring.Offsets.push_back(colouring.Offsets.back() + counts[c]);
+	colouring.Links.clear();
+	for (int c = 0; c <= maxColours; c++)
+		for (int i = 0; i < links; i++)
+			if (colours[i] == c)
+				colouring.Links.push_back(i);
+	return colouring;
+}
+
+// Same as btSoftBody::PSolve_Links and VSolve_Links, a colour at a time
+void ParallelSoftBodySolver::SolveLinks(btSoftBody *psb,
+	const Colouring& colouring, bool velocities)
+{
+	const int *order = colouring.Links.data();
+	for (std::size_t c = 0; c + 1 < colouring.Offsets.size(); c++)
+	{
+		int first = colouring.Offsets[c];
+		int count = colouring.Offsets[c + 1] - first;
+		// The overflow colour can share nodes
+		bool serial = colouring.Overflow
+			&& c + 2 == colouring.Offsets.size();
+		WorkerPool::RangeFunc solve = [&](int begin, int end)
+		{
+			for (int i = first + begin; i < first + end; i++)
+			{
+				btSoftBody::Link& l = psb->m_links[order[i]];
+				btSoftBody::Node& a = *l.m_n[0];
+				btSoftBody::Node& b = *l.m_n[1];
+				if (velocities)
+				{
+					const btScalar j = -btDot(l.m_c3, a.m_v - b.m_v) * l.m_c2;
+					a.m_v += l.m_c3 * (j * a.m_im);
+					b.m_v -= l.m_c3 * (j * b.m_im);
+				}
+				else if (l.m_c0 > 0)
+				{
+					const btVector3 del = b.m_x - a.m_x;
+					const btScalar len = del.length2();
+					if (l.m_c1 + len > SIMD_EPSILON)
+					{
+						const btScalar k = (l.m_c1 - len)
+							/ (l.m_c0 * (l.m_c1 + len));
+						a.m_x -= del * (k * a.m_im);
+						b.m_x += del * (k * b.m_im);
+					}
+				}
+			}
+		};
+		if (serial)
+			solve(0, count);
+		else
+			ForEach(count, solve);
+	}
+}
+
+// Follows btSoftBody::solveConstraints, with the per-node and per-link loops
+// split across the pool
+void ParallelSoftBodySolver::Solve(btSoftBody *psb)
+{
+	const Colouring& colouring = GetColouring(psb);
+	Colours = (int)colouring.Offsets.size() - 1;
+	// Decided for the whole solve, since a small body's colours are each
+	// too little work to wake the workers for
+	parallel = psb->m_links.size() >= minLinks;
+	btSoftBody::Config& cfg = psb->m_cfg;
+	const btScalar sdt = psb->m_sst.sdt;
+	int nodes = psb->m_nodes.size();
+
+	psb->applyClusters(false);
+
+	ForEach(psb->m_links.size(), [psb](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			btSoftBody::Link& l = psb->m_links[i];
+			l.m_c3 = l.m_n[1]->m_q - l.m_n[0]->m_q;
+			l.m_c2 = 1 / (l.m_c3.length2() * l.m_c0);
+		}
+	});
+	for (int i = 0, n = psb->m_anchors.size(); i < n; i++)
+	{
+		btSoftBody::Anchor& a = psb->m_anchors[i];
+		const btVector3 ra = a.m_body->getWorldTransform().getBasis()
+			* a.m_local;
+		a.m_c0 = ImpulseMatrix(sdt, a.m_node->m_im, a.m_body->getInvMass(),
+			a.m_body->getInvInertiaTensorWorld(), ra);
+		a.m_c1 = ra;
+		a.m_c2 = sdt * a.m_node->m_im;
+		a.m_body->activate();
+	}
+
+	if (cfg.viterations > 0)
+	{
+		for (int isolve = 0; isolve < cfg.viterations; isolve++)
+			for (int iseq = 0; iseq < cfg.m_vsequence.size(); iseq++)
+				if (cfg.m_vsequence[iseq] == btSoftBody::eVSolver::Linear)
+					SolveLinks(psb, colouring, true);
+				else
+					btSoftBody::getSolver(cfg.m_vsequence[iseq])(psb, 1);
+		ForEach(nodes, [psb, sdt](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				btSoftBody::Node& n = psb->m_nodes[i];
+				n.m_x = n.m_q + n.m_v * sdt;
+			}
+		});
+	}
+
+	if (cfg.piterations > 0)
+	{
+		for (int isolve = 0; isolve < cfg.piterations; isolve++)
+		{
+			const btScalar ti = isolve / (btScalar)cfg.piterations;
+			for (int iseq = 0; iseq < cfg.m_psequence.size(); iseq++)
+				if (cfg.m_psequence[iseq] == btSoftBody::ePSolver::Linear)
+					SolveLinks(psb, colouring, false);
+				else
+					btSoftBody::getSolver(cfg.m_psequence[iseq])(psb, 1, ti);
+		}
+		const btScalar vc = psb->m_sst.isdt * (1 - cfg.kDP);
+		ForEach(nodes, [psb, vc](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				btSoftBody::Node& n = psb->m_nodes[i];
+				n.m_v = (n.m_x - n.m_q) * vc;
+				n.m_f = btVector3(0, 0, 0);
+			}
+		});
+	}
+
+	if (cfg.diterations > 0)
+	{
+		const btScalar vcf = cfg.kVCF * psb->m_sst.isdt;
+		for (int i = 0; i < nodes; i++)
+			psb->m_nodes[i].m_q = psb->m_nodes[i].m_x;
+		for (int idrift = 0; idrift < cfg.diterations; idrift++)
+			for (int iseq = 0; iseq < cfg.m_dsequence.size(); iseq++)
+				if (cfg.m_dsequence[iseq] == btSoftBody::ePSolver::Linear)
+					SolveLinks(psb, colouring, false);
+				else
+					btSoftBody::getSolver(cfg.m_dsequence[iseq])(psb, 1, 0);
+		for (int i = 0; i < nodes; i++)
+		{
+			btSoftBody::Node& n = psb->m_nodes[i];
+			n.m_v += (n.m_x - n.m_q) * vcf;
+		}
+	}
+
+	psb->dampClusters();
+	psb->applyClusters(true);
+}
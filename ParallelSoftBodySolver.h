@@ -0,0 +1,56 @@
+#pragma once
+
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+#include <BulletSoftBody/btSoftBody.h>
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "WorkerPool.h"
+#include "config.h"
+
+// Solves soft body links across worker threads. Links are graph coloured so
+// no two in a colour share a node; each colour is then solved in parallel
+// without locks. Results only depend on the colouring, never on the thread
+// count, though they differ slightly from Bullet's serial order. Anchors
+// and contacts push on rigid bodies, so they stay serial. Bodies with
+// fewer than minLinks links are solved on the calling thread alone.
+class ParallelSoftBodySolver : public btDefaultSoftBodySolver
+{
+	public:
+		ParallelSoftBodySolver(int threads = SOFTBODY_SOLVER_THREADS,
+			int p_minLinks = SOFTBODY_PARALLEL_MIN_LINKS);
+
+		virtual void solveConstraints(float solverdt);
+
+		int Threads() const { return pool.Threads(); }
+		// Of the last solve, for the GUI
+		float SolveTime = 0.f;
+		int Colours = 0;
+
+	private:
+		struct Colouring
+		{
+			int Nodes = 0;
+			// Node indices of each link, to notice a changed topology
+			std::vector<int> LinkNodes;
+			// Link indices grouped by colour, Offsets[c] to Offsets[c + 1]
+			std::vector<int> Links;
+			std::vector<int> Offsets;
+			// Whether the last colour holds links that share nodes
+			bool Overflow = false;
+		};
+
+		WorkerPool pool;
+		int minLinks;
+		// Whether the body being solved is big enough for the workers
+		bool parallel = false;
+		std::map<btSoftBody *, Colouring> colourings;
+
+		const Colouring& GetColouring(btSoftBody *psb);
+		void Solve(btSoftBody *psb);
+		void SolveLinks(btSoftBody *psb, const Colouring& colouring,
+			bool velocities);
+		void ForEach(int count, const WorkerPool::RangeFunc& func);
+};
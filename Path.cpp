@@ -1,35 +1,84 @@
 #include "Path.h"
 #include "config.h"
 
+#include <algorithm>
+#include <cmath>
+
+unsigned int Path::nextRevision = 0;
+unsigned int Path::changes = 0;
+
 void Path::Reset()
 {
 	position = 0.0f;
+	revision = 0;
+	changes++;
 }
 
-bool Path::Step(float dt)
+void Path::Bake()
 {
-	if (Loop)
+	table.clear();
+	length = spacing = stepLength = 0.0f;
+	revision = ++nextRevision;
+	if (revision == 0)
+		revision = ++nextRevision;
+	changes++;
+	if (Points.empty())
+	{
+		position = 0.0f;
+		current = glm::vec3(0);
+		return;
+	}
+
+	int segments = (int)Points.size() - (Loop ? 0 : 1);
+	if (segments < 1)
 	{
-		float path_length = (float)Points.size();
-		position += Speed * PLATFORM_SPEED_MODIFIER * dt;
-		if (position > path_length)
-			position = 0.0f;
+		table.push_back(Points[0]);
+		position = 0.0f;
+		current = Points[0];
+		return;
 	}
-	else
+
+	// Finely in t first, with the distance travelled to each sample
+	int n = segments * PATH_BAKE_SUBDIVISIONS;
+	std::vector<glm::vec3> curve(n + 1);
+	std::vector<float> distance(n + 1);
+	curve[0] = GetPosition(0.0f);
+	distance[0] = 0.0f;
+	for (int i = 1; i <= n; i++)
 	{
-		float path_length = (float)(Points.size() - 1);
-		if (position == path_length)
-			return false;
-		position += Speed * PLATFORM_SPEED_MODIFIER * dt;
-		if (position > path_length)
-			position = path_length;
+		curve[i] = GetPosition((float)i / PATH_BAKE_SUBDIVISIONS);
+		distance[i] = distance[i - 1] + glm::distance(curve[i - 1], curve[i]);
 	}
-	return true;
+	length = distance[n];
+	// Laps take as long as they did when speed was in control points
+	stepLength = length / segments;
+
+	// Then evenly in distance
+	int count = std::max(2, (int)std::ceil(length / PATH_TABLE_SPACING) + 1);
+	spacing = length / (count - 1);
+	table.resize(count);
+	for (int i = 0, j = 0; i < count; i++)
+	{
+		float d = std::min(i * spacing, length);
+		while (j < n - 1 && distance[j + 1] < d)
+			j++;
+		float span = distance[j + 1] - distance[j];
+		float f = span > 0.0f ? (d - distance[j]) / span : 0.0f;
+		table[i] = glm::mix(curve[j], curve[j + 1], glm::clamp(f, 0.0f, 1.0f));
+	}
+
+	position = glm::clamp(position, 0.0f, length);
+	current = Sample(position);
 }
 
-glm::vec3 Path::GetPosition()
+glm::vec3 Path::Sample(float distance) const
 {
-	return GetPosition(position);
+	int last = (int)table.size() - 1;
+	if (last < 1)
+		return table.empty() ? glm::vec3(0) : table[0];
+	float f = spacing > 0.0f ? distance / spacing : 0.0f;
+	int i = std::min((int)f, last - 1);
+	return glm::mix(table[i], table[i + 1], f - i);
 }
 
 glm::vec3 Path::GetPosition(float time)
@@ -6,6 +6,7 @@
 class Path
 {
 	typedef std::vector<glm::vec3>::iterator iterator;
+	friend class PathBatch;
 
 	public:
 		std::vector<glm::vec3> Points;
@@ -14,14 +15,37 @@ class Path
 		bool Curved = true;
 		bool Enabled = false;
 
-		Path() = default;
+		Path() { changes++; }
 		void Reset();
-		bool Step(float dt = 1.0f);
-		glm::vec3 GetPosition();
+		// After changing the points, Loop or Curved
+		void Invalidate() { revision = 0; changes++; }
+		bool IsBaked() const { return revision != 0; }
+		// Resamples the curve evenly by distance, so it can be followed at
+		// a constant speed with a table lookup
+		void Bake();
+		// Where the last PathBatch step left it
+		glm::vec3 GetPosition() { return current; }
+		// On the curve itself, t counting control points
 		glm::vec3 GetPosition(float t);
 		glm::vec3 GetPoint(int p);
 
 	private:
+		// Distance along the path
 		float position = 0.0f;
+		glm::vec3 current;
+
+		std::vector<glm::vec3> table;
+		float length = 0.0f;
+		float spacing = 0.0f;
+		// Distance per tick at a Speed of one
+		float stepLength = 0.0f;
+		// Unique per bake
+		unsigned int revision = 0;
+		static unsigned int nextRevision;
+		// Counts paths made, reset, invalidated and baked, so a batch can
+		// tell it's out of date without looking at every path
+		static unsigned int changes;
+
 		glm::vec3 CatmullRomTangent(int p);
+		glm::vec3 Sample(float distance) const;
 };
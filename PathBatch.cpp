@@ -0,0 +1,84 @@
+#include "PathBatch.h"
+#include "config.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool PathBatch::Changed(const std::vector<GameObject *>& objects)
+{
+	// A new object reusing a deleted one's address made a new path, which
+	// counts as a change
+	return changes != Path::changes || gathered != objects;
+}
+
+void PathBatch::Build(const std::vector<GameObject *>& objects)
+{
+	paths.clear();
+	for (GameObject *ent : objects)
+	{
+		Path *path = &ent->motion;
+		if (path->Points.empty())
+			continue;
+		if (!path->IsBaked())
+			path->Bake();
+		paths.push_back(path);
+	}
+	gathered = objects;
+	changes = Path::changes;
+
+	std::size_t n = paths.size();
+	offset.resize(n);
+	last.resize(n);
+	invSpacing.resize(n);
+	length.resize(n);
+	distance.resize(n);
+	stepLength.resize(n);
+	loop.resize(n);
+	samples.clear();
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const Path *path = paths[i];
+		offset[i] = (int)samples.size();
+		last[i] = (int)path->table.size() - 1;
+		invSpacing[i] = path->spacing > 0.0f ? 1.0f / path->spacing : 0.0f;
+		length[i] = path->length;
+		distance[i] = path->position;
+		stepLength[i] = path->stepLength;
+		loop[i] = path->Loop;
+		samples.insert(samples.end(), path->table.begin(), path->table.end());
+	}
+}
+
+void PathBatch::Step(const std::vector<GameObject *>& objects)
+{
+	if (Changed(objects))
+		Build(objects);
+
+	const glm::vec3 *table = samples.data();
+	int n = (int)paths.size();
+	for (int i = 0; i < n; i++)
+	{
+		Path *path = paths[i];
+		// Triggers and the editor switch paths on and off and change speeds
+		float d = distance[i];
+		if (path->Enabled)
+		{
+			d += path->Speed * PLATFORM_SPEED_MODIFIER * stepLength[i];
+			if (d >= length[i])
+				d = loop[i] && length[i] > 0.0f ?
+					std::fmod(d, length[i]) : length[i];
+			distance[i] = d;
+		}
+
+		path->position = d;
+		if (last[i] < 1)
+		{
+			path->current = table[offset[i]];
+			continue;
+		}
+		float f = d * invSpacing[i];
+		int j = std::min((int)f, last[i] - 1);
+		const glm::vec3 *p = table + offset[i] + j;
+		path->current = glm::mix(p[0], p[1], f - j);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "GameObject.h"
+
+// Advances every object with a path in one pass. The paths' baked tables
+// are copied back to back, with the per-path state alongside as arrays,
+// so stepping thousands of movers touches each path once and otherwise
+// walks contiguous memory.
+class PathBatch
+{
+	public:
+		// Rebakes paths and regathers the batch when objects or their
+		// paths have changed, then steps. Simulation thread, world locked.
+		void Step(const std::vector<GameObject *>& objects);
+
+		int Count() const { return (int)paths.size(); }
+
+	private:
+		// What the batch was gathered from
+		std::vector<GameObject *> gathered;
+		unsigned int changes = 0;
+		std::vector<Path *> paths;
+
+		std::vector<glm::vec3> samples;
+		std::vector<int> offset;
+		std::vector<int> last;
+		std::vector<float> invSpacing;
+		std::vector<float> length;
+		std::vector<float> distance;
+		std::vector<float> stepLength;
+		std::vector<unsigned char> loop;
+
+		bool Changed(const std::vector<GameObject *>& objects);
+		void Build(const std::vector<GameObject *>& objects);
+};
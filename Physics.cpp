@@ -2,44 +2,50 @@
 #include "config.h"
 #include "GameObject.h"
 
+#include <vector>
+#include <utility>
+
 Blob *Physics::blob;
 btSoftRigidDynamicsWorld *Physics::dynamicsWorld;
 btCollisionDispatcher *Physics::dispatcher;
 btBroadphaseInterface *Physics::broadphase;
 btSequentialImpulseConstraintSolver *Physics::solver;
 btSoftBodyRigidBodyCollisionConfiguration *Physics::collisionConfiguration;
-btSoftBodySolver *Physics::softBodySolver;
+ParallelSoftBodySolver *Physics::softBodySolver;
 
 btSoftBodyWorldInfo Physics::softBodyWorldInfo;
 
 bool Physics::bStepPhysics = false;
 bool Physics::bShowBulletDebug = true;
 
+std::mutex Physics::worldMutex;
+std::atomic<bool> Physics::blobRequested{ false };
+std::atomic<bool> Physics::stepRequested{ false };
+static glm::vec4 requestedColor;
+Physics::Broadphase Physics::broadphaseType = Physics::Broadphase::Sap;
+
+const char *Physics::broadphaseNames[(int)Broadphase::Count] =
+	{ "dbvt", "sap", "sap32" };
 
-btScalar Physics::ContactResultCallback::addSingleResult(btManifoldPoint& cp,
-	const btCollisionObjectWrapper* colObj0Wrap,
-	int partId0,
-	int index0,
-	const btCollisionObjectWrapper* colObj1Wrap,
-	int partId1,
-	int index1)
+static btBroadphaseInterface *NewBroadphase(Physics::Broadphase type,
+	const btVector3& aabbMin, const btVector3& aabbMax)
 {
-	GameObject* go =
-	(GameObject*)colObj1Wrap->getCollisionObject()->
-	getUserPointer();
-
-	if (go->GetMass() != 0
-		&& go->GetMass() != MOVING_PLATFORM_MASS)
-		*context = true;
-	return 0;
+	switch (type)
+	{
+	case Physics::Broadphase::Sap:
+		return new btAxisSweep3(aabbMin, aabbMax, MAX_PROXIES);
+	case Physics::Broadphase::Sap32:
+		return new bt32BitAxisSweep3(aabbMin, aabbMax, MAX_PROXIES);
+	default:
+		return new btDbvtBroadphase();
+	}
 }
 
 void Physics::Init()
 {
-	broadphase = new btDbvtBroadphase();
-	btVector3 worldAabbMin(-1000, -1000, -1000);
-	btVector3 worldAabbMax(1000, 1000, 1000);
-	broadphase = new btAxisSweep3(worldAabbMin, worldAabbMax, MAX_PROXIES);
+	// Levels fit the bounds to themselves once loaded
+	broadphase = NewBroadphase(broadphaseType,
+		btVector3(-1000, -1000, -1000), btVector3(1000, 1000, 1000));
 
 	collisionConfiguration =
 		new btSoftBodyRigidBodyCollisionConfiguration();
@@ -48,7 +54,7 @@ void Physics::Init()
 
 	//new btConstraintSolver()
 
-	softBodySolver = new btDefaultSoftBodySolver();
+	softBodySolver = new ParallelSoftBodySolver();
 	dynamicsWorld = new btSoftRigidDynamicsWorld(dispatcher,
 		broadphase, solver, collisionConfiguration, softBodySolver);
 
@@ -69,6 +75,7 @@ void Physics::Init()
 void Physics::Cleanup()
 {
 	delete Physics::dynamicsWorld;
+	delete Physics::softBodySolver;
 	delete Physics::solver;
 	delete Physics::collisionConfiguration;
 	delete Physics::dispatcher;
@@ -76,6 +83,55 @@ void Physics::Cleanup()
 	delete Physics::blob;
 }
 
+void Physics::SetBroadphase(Broadphase type, const btVector3& aabbMin,
+	const btVector3& aabbMax)
+{
+	btBroadphaseInterface *old = broadphase;
+	btCollisionObjectArray& objects = dynamicsWorld->getCollisionObjectArray();
+	std::vector<std::pair<short, short>> filters(objects.size());
+	for (int i = 0; i < objects.size(); i++)
+	{
+		btBroadphaseProxy *proxy = objects[i]->getBroadphaseHandle();
+		if (!proxy)
+			continue;
+		filters[i] = std::make_pair(proxy->m_collisionFilterGroup,
+			proxy->m_collisionFilterMask);
+		old->destroyProxy(proxy, dispatcher);
+		objects[i]->setBroadphaseHandle(nullptr);
+	}
+
+	broadphase = NewBroadphase(type, aabbMin, aabbMax);
+	broadphaseType = type;
+	dynamicsWorld->setBroadphase(broadphase);
+	softBodyWorldInfo.m_broadphase = broadphase;
+	delete old;
+
+	for (int i = 0; i < objects.size(); i++)
+	{
+		btCollisionObject *object = objects[i];
+		btVector3 min, max;
+		object->getCollisionShape()->getAabb(object->getWorldTransform(),
+			min, max);
+		object->setBroadphaseHandle(broadphase->createProxy(min, max,
+			object->getCollisionShape()->getShapeType(), object,
+			filters[i].first, filters[i].second, dispatcher, 0));
+		dynamicsWorld->updateSingleAabb(object);
+	}
+}
+
+bool Physics::ParseBroadphase(const std::string& name, Broadphase& type)
+{
+	for (int i = 0; i < (int)Broadphase::Count; i++)
+	{
+		if (name == broadphaseNames[i])
+		{
+			type = (Broadphase)i;
+			return true;
+		}
+	}
+	return false;
+}
+
 void Physics::CreateBlob(glm::vec4 color)
 {
 	if (blob)
@@ -84,41 +140,42 @@ void Physics::CreateBlob(glm::vec4 color)
 		delete blob;
 	}
 	blob = new Blob(Physics::softBodyWorldInfo,
-		btVector3(0, 15, 0), 3.0f, 512);
+		btVector3(0, 15, 0), 3.0f, BLOB_NODES);
 	blob->color = color;
 	dynamicsWorld->addSoftBody(blob->softbody);
 }
 
-bool Physics::BroadphaseCheck(btCollisionObject* obj1,
-	btCollisionObject* obj2)
+void Physics::RespawnBlob(glm::vec4 color)
 {
-	btBroadphasePair* pair =
-		Physics::broadphase->getOverlappingPairCache()->findPair(
-			obj1->getBroadphaseHandle(),
-			obj2->getBroadphaseHandle());
-	return (pair != NULL);
+	if (!blob)
+	{
+		CreateBlob(color);
+		return;
+	}
+	blob->Reset();
+	blob->color = color;
 }
 
-bool Physics::NarrowphaseCheck(btSoftBody* sb,
-	btCollisionObject* rb)
+void Physics::RequestBlob(glm::vec4 color)
 {
-	for (int i = 0; i < sb->m_rcontacts.size(); i++)
-		if (sb->m_rcontacts[i].m_cti.m_colObj == rb)
-			return true;
-
-	return false;
-	//return obj1->checkCollideWith(obj2); //Always returns true..
+	requestedColor = color;
+	blobRequested = true;
 }
 
-bool Physics::NarrowphaseCheck(btCollisionObject* rb, btSoftBody* sb)
+bool Physics::TakeBlobRequest(glm::vec4& color)
 {
-	return NarrowphaseCheck(sb, rb);
+	if (!blobRequested.exchange(false))
+		return false;
+	color = requestedColor;
+	return true;
 }
 
-//OnEnter
-//OnStay
-//OnLeave
+void Physics::RequestStep()
+{
+	stepRequested = true;
+}
 
-//For trigger objects
-/*mBody->setCollisionFlags(mBody->getCollisionFlags() |
-btCollisionObject::CF_NO_CONTACT_RESPONSE));*/
+bool Physics::TakeStepRequest()
+{
+	return stepRequested.exchange(false);
+}
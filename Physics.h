@@ -9,65 +9,59 @@
 #include <glm/glm.hpp>
 
 #include <iostream>
+#include <string>
+#include <mutex>
+#include <atomic>
 #include "config.h"
 #include "Blob.h"
+#include "ParallelSoftBodySolver.h"
 //#include "GameObject.h"
 
 class Physics
 {
 public:
+	enum class Broadphase { Dbvt, Sap, Sap32, Count };
+	static const char *broadphaseNames[(int)Broadphase::Count];
+
 	static Blob *blob;
 	static btSoftRigidDynamicsWorld *dynamicsWorld;
 	static btCollisionDispatcher *dispatcher;
 	static btBroadphaseInterface *broadphase;
+	static Broadphase broadphaseType;
 	static btSequentialImpulseConstraintSolver *solver;
 	static btSoftBodyRigidBodyCollisionConfiguration *collisionConfiguration;
-	static btSoftBodySolver *softBodySolver;
+	static ParallelSoftBodySolver *softBodySolver;
 
 	static btSoftBodyWorldInfo softBodyWorldInfo;
 
 	static bool bStepPhysics;
 	static bool bShowBulletDebug;
 
+	// Held by the simulation thread while it ticks; take it before touching
+	// the world from anywhere else
+	static std::mutex worldMutex;
+
 	static void Init();
 	static void Cleanup();
 
-	static void CreateBlob(glm::vec4 color = glm::vec4(0,1,0,1));
-
-	struct ContactResultCallback : 
-		public btCollisionWorld::ContactResultCallback
-	{
-		ContactResultCallback(bool* ptr) : context(ptr) {}
-
-		btScalar addSingleResult(btManifoldPoint& cp,
-			const btCollisionObjectWrapper* colObj0Wrap,
-			int partId0,
-			int index0,
-			const btCollisionObjectWrapper* colObj1Wrap,
-			int partId1,
-			int index1);
+	// Replaces the broadphase, moving everything in the world over to it.
+	// The bounds are only used by the sweep and prune ones.
+	static void SetBroadphase(Broadphase type, const btVector3& aabbMin,
+		const btVector3& aabbMax);
+	static bool ParseBroadphase(const std::string& name, Broadphase& type);
 
-		bool* context;
-	};
-
-	static bool BroadphaseCheck(btCollisionObject* obj1,
-		btCollisionObject* obj2);
-	static bool NarrowphaseCheck(btSoftBody* sb, btCollisionObject* rb);
-	static bool NarrowphaseCheck(btCollisionObject* rb, btSoftBody* sb);
-
-	static glm::vec3 InverseDynamics(glm::vec3 currentPosition, 
-		glm::vec3 desiredPosition, glm::vec3 currentVelocity, float mass,
-		float deltaTime)
-	{
-		//desiredPosition = currentPosition + requiredVelocity * dt
-		glm::vec3 requiredVelocity = 
-			(desiredPosition - currentPosition) / deltaTime; 
-
-		//requiredVelocity = currentVelocity + requiredAccel * dt;																	  
-		glm::vec3 requiredAccel = (requiredVelocity - currentVelocity) 
-			/ deltaTime;
-		
-		//F=ma
-		return mass * requiredAccel;
-	}
+	static void CreateBlob(glm::vec4 color = glm::vec4(0,1,0,1));
+	// Resets the blob to its spawn in place, creating it if there is none
+	static void RespawnBlob(glm::vec4 color = glm::vec4(0,1,0,1));
+	// Triggers fire mid-tick, so the simulation thread asks for a respawn
+	// here and the main thread does it between ticks. Both with the world
+	// locked.
+	static void RequestBlob(glm::vec4 color = glm::vec4(0,1,0,1));
+	static bool TakeBlobRequest(glm::vec4& color);
+	static std::atomic<bool> blobRequested;
+	// Runs the next tick's step even while paused, so single steps from the
+	// editor go through the same tick as the rest
+	static void RequestStep();
+	static bool TakeStepRequest();
+	static std::atomic<bool> stepRequested;
 };
@@ -134,7 +134,7 @@ void RenderingManager::drawBlob(Blob *blob, glm::vec3 camPos, glm::mat4 viewMatr
 	(*blobShader)["directionalLight.direction"] = dirLight.direction;
 	(*blobShader)["viewPos"] = camPos;
 	(*blobShader)["blobDistance"] =
-		glm::distance(convert(blob->GetCentroid()), camPos);
+		glm::distance(convert(blob->GetRenderCentroid()), camPos);
 
 	(*blobShader)["projection"] = projMatrix;
 	(*blobShader)["view"] = viewMatrix;
@@ -302,7 +302,7 @@ void RenderingManager::dynamicCubeMapPass(Blob *blob, Level *level)
 	glViewport(0, 0, TEX_WIDTH, TEX_HEIGHT);
 	glm::mat4 projMatrix = glm::perspective(glm::radians(90.0f), (float)TEX_WIDTH / (float)TEX_HEIGHT, 0.1f, 500.0f);
 
-	glm::vec3 position = convert(blob->GetCentroid());
+	glm::vec3 position = convert(blob->GetRenderCentroid());
 	drawCubeFace(
 		position,
 		glm::vec3(1.0f, 0.0f, 0.0f),
@@ -0,0 +1,170 @@
+#include "SimulationThread.h"
+#include "Physics.h"
+#include <GLFW/glfw3.h>
+#include <glm/gtx/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+
+void SimulationSnapshot::Capture(Blob *blob, Level *level, bool stepped)
+{
+	btSoftBody *sb = blob->softbody;
+	int n = sb->m_nodes.size();
+	Vertices.resize(n);
+	Normals.resize(n);
+	for (int i = 0; i < n; i++)
+	{
+		Vertices[i] = convert(sb->m_nodes[i].m_x);
+		Normals[i] = convert(sb->m_nodes[i].m_n);
+	}
+	// A respawned blob has no previous state yet
+	if (stepped && blob->previousVertices.size() == (std::size_t)n)
+		PreviousVertices = blob->previousVertices;
+	else
+		PreviousVertices = Vertices;
+
+	Centroid = convert(blob->GetCentroid());
+	PreviousCentroid = stepped ? convert(blob->GetPreviousCentroid())
+		: Centroid;
+
+	Objects.resize(level->Objects.size());
+	for (std::size_t i = 0, m = Objects.size(); i < m; i++)
+	{
+		GameObject *ent = level->Objects[i];
+		Object& o = Objects[i];
+		const btTransform& current = ent->rigidbody->getWorldTransform();
+		btTransform previous = stepped ? ent->GetPreviousTransform()
+			: current;
+		o.ID = ent->ID;
+		o.Position = convert(current.getOrigin());
+		o.PreviousPosition = convert(previous.getOrigin());
+		o.Rotation = convert(current.getRotation());
+		o.PreviousRotation = convert(previous.getRotation());
+		o.Scale = ent->GetScale();
+		o.Color = ent->color;
+	}
+}
+
+void SimulationSnapshot::Apply(Blob *blob, Level *level, float alpha) const
+{
+	// Nothing has been simulated yet
+	if (Vertices.empty())
+		return;
+
+	blob->Update(PreviousVertices, Vertices, Normals,
+		convert(glm::mix(PreviousCentroid, Centroid, alpha)), alpha);
+
+	// Objects the editor added or removed since are picked up by the next
+	// snapshot
+	std::size_t n = std::min(Objects.size(), level->Objects.size());
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const Object& o = Objects[i];
+		GameObject *ent = level->Objects[i];
+		if (ent->ID != o.ID)
+			continue;
+		ent->SetRenderState(
+			glm::translate(glm::mat4(1),
+				glm::mix(o.PreviousPosition, o.Position, alpha))
+			* glm::toMat4(glm::slerp(o.PreviousRotation, o.Rotation, alpha))
+			* glm::scale(glm::mat4(1), o.Scale),
+			o.Color);
+	}
+}
+
+TickSchedule::TickSchedule(Clock::duration p_interval,
+	Clock::time_point start) :
+	interval(p_interval), next(start)
+{ }
+
+int TickSchedule::Due(Clock::time_point now)
+{
+	if (now < next)
+		return 0;
+
+	long behind = (long)((now - next) / interval);
+	if (behind >= MAX_CATCH_UP_TICKS)
+	{
+		Dropped += behind - MAX_CATCH_UP_TICKS + 1;
+		next += interval * (behind - MAX_CATCH_UP_TICKS + 1);
+		behind = MAX_CATCH_UP_TICKS - 1;
+	}
+	next += interval * (behind + 1);
+	return (int)behind + 1;
+}
+
+SimulationThread::SimulationThread(TickFunc p_tick) :
+	tick(p_tick)
+{ }
+
+SimulationThread::~SimulationThread()
+{
+	Stop();
+}
+
+void SimulationThread::Start()
+{
+	running = true;
+	thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop()
+{
+	running = false;
+	if (thread.joinable())
+		thread.join();
+}
+
+const SimulationSnapshot& SimulationThread::Latest()
+{
+	if (middle.load() & Fresh)
+		front = middle.exchange(front) & ~Fresh;
+	return buffers[front];
+}
+
+void SimulationThread::Run()
+{
+	typedef std::chrono::steady_clock clock;
+	TickSchedule schedule(std::chrono::duration_cast<clock::duration>(
+		std::chrono::duration<double>(SIMULATION_TIMESTEP)), clock::now());
+	clock::time_point second = clock::now();
+	clock::duration busy(0);
+	uint32_t ticks = 0;
+	while (running)
+	{
+		std::this_thread::sleep_until(schedule.Next());
+
+		clock::time_point now = clock::now();
+		int due = schedule.Due(now);
+		Dropped = schedule.Dropped;
+
+		int ran = 0;
+		for (; ran < due && running; ran++)
+		{
+			clock::time_point start = clock::now();
+			SimulationSnapshot& snapshot = buffers[back];
+			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
+				tick(snapshot);
+			}
+			snapshot.Tick = ticks++;
+			snapshot.Time = glfwGetTime();
+			back = middle.exchange(back | Fresh) & ~Fresh;
+			clock::time_point end = clock::now();
+
+			busy += end - start;
+			TickTime = std::chrono::duration<float, std::milli>(end - start)
+				.count();
+		}
+		if (ran > 1)
+			CaughtUp += ran - 1;
+
+		if (now - second >= std::chrono::seconds(1))
+		{
+			Load = std::chrono::duration<float>(busy).count()
+				/ std::chrono::duration<float>(now - second).count();
+			busy = clock::duration(0);
+			second = now;
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Blob.h"
+#include "Level.h"
+#include "InputWindow.h"
+#include "config.h"
+
+// Everything drawing and encoding need from one simulation tick, along with
+// the tick before it to interpolate from. Never written once published.
+struct SimulationSnapshot
+{
+	// The info box's figures from state the simulation thread owns
+	struct Figures
+	{
+		int Voting = 0;
+		float SolveTime = 0.f;
+		int Colours = 0;
+		int Touched = 0;
+		int Pairs = 0;
+	};
+
+	struct Object
+	{
+		int ID;
+		glm::vec3 Position;
+		glm::vec3 PreviousPosition;
+		glm::quat Rotation;
+		glm::quat PreviousRotation;
+		glm::vec3 Scale;
+		glm::vec4 Color;
+	};
+
+	uint32_t Tick = 0;
+	double Time = 0.0;
+	std::vector<glm::vec3> Vertices;
+	std::vector<glm::vec3> PreviousVertices;
+	std::vector<glm::vec3> Normals;
+	glm::vec3 Centroid;
+	glm::vec3 PreviousCentroid;
+	std::vector<Object> Objects;
+	InputMagnitudes Inputs;
+	Figures Stats;
+
+	// Simulation thread, with the world locked. Without a step the previous
+	// state is the current one.
+	void Capture(Blob *blob, Level *level, bool stepped);
+	// Main thread; alpha is how far rendering is from the previous tick to
+	// this one
+	void Apply(Blob *blob, Level *level, float alpha) const;
+};
+
+// Fixed timestep accounting. Late ticks are caught up, but time beyond
+// MAX_CATCH_UP_TICKS is dropped instead of spiralling.
+class TickSchedule
+{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		TickSchedule(Clock::duration p_interval, Clock::time_point start);
+
+		// Ticks due by now, which are then counted as run
+		int Due(Clock::time_point now);
+		Clock::time_point Next() const { return next; }
+
+		uint64_t Dropped = 0;
+
+	private:
+		Clock::duration interval;
+		Clock::time_point next;
+};
+
+// Steps the world at SIMULATION_TIMESTEP on its own thread, so simulation
+// overlaps drawing and encoding. Each tick runs with Physics::worldMutex
+// held. Finished snapshots go through a triple buffer: the simulation
+// always has a slot to write, the main thread always has a complete one to
+// read, and neither waits for the other.
+class SimulationThread
+{
+	public:
+		// Runs one tick and captures it, with the world locked
+		typedef std::function<void(SimulationSnapshot&)> TickFunc;
+
+		SimulationThread(TickFunc p_tick);
+		~SimulationThread();
+		SimulationThread(const SimulationThread&) = delete;
+		SimulationThread& operator=(const SimulationThread&) = delete;
+
+		void Start();
+		void Stop();
+
+		// Main thread. Valid until the next call.
+		const SimulationSnapshot& Latest();
+
+		// Fraction of the last second spent ticking
+		std::atomic<float> Load{ 0.f };
+		std::atomic<float> TickTime{ 0.f };
+		std::atomic<uint64_t> CaughtUp{ 0 };
+		std::atomic<uint64_t> Dropped{ 0 };
+
+	private:
+		TickFunc tick;
+		std::thread thread;
+		std::atomic<bool> running{ false };
+
+		void Run();
+
+		enum { Fresh = 4 };
+		SimulationSnapshot buffers[3];
+		// Owned by the simulation thread
+		int back = 0;
+		// Owned by the main thread
+		int front = 1;
+		// Handed between them, flagged Fresh when newer than front
+		std::atomic<int> middle{ 2 };
+};
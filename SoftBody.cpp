@@ -1,6 +1,6 @@
 #include "SoftBody.h"
 
-SoftBody::SoftBody(btSoftBody* p_softBody)
+SoftBody::SoftBody(btSoftBody* p_softBody, bool meshes)
 {
 	softbody = p_softBody;
 
@@ -20,6 +20,8 @@ SoftBody::SoftBody(btSoftBody* p_softBody)
 		vertices[i] = convert(softbody->m_nodes[i].m_x);
 		normals[i] = convert(softbody->m_nodes[i].m_n);
 	}
+	if (!meshes)
+		return;
 
 	glGenVertexArrays(1, &vao);
 	VBOs = new GLuint[2];
@@ -47,15 +49,25 @@ SoftBody::SoftBody(btSoftBody* p_softBody)
 
 SoftBody::~SoftBody()
 {
-	glDeleteVertexArrays(1, &vao);
+	if (VBOs)
+		glDeleteVertexArrays(1, &vao);
 	delete softbody;
 	delete[] VBOs;
 }
 
-void SoftBody::Update()
+void SoftBody::SaveState()
+{
+	previousVertices.resize(softbody->m_nodes.size());
+	for (int i = 0, n = softbody->m_nodes.size(); i < n; i++)
+		previousVertices[i] = convert(softbody->m_nodes[i].m_x);
+}
+
+void SoftBody::Update(float alpha)
 {
 	vertices = std::vector<glm::vec3>(softbody->m_nodes.size());
 	normals = std::vector<glm::vec3>(softbody->m_nodes.size());
+	bool interpolate = alpha < 1.f
+		&& previousVertices.size() == vertices.size();
 #pragma loop(hint_parallel(0))
 #pragma loop(ivdep)
 	for (int i = 0, n = softbody->m_nodes.size(); i < n; i++)
@@ -63,14 +75,56 @@ void SoftBody::Update()
 		vertices[i] = convert(softbody->m_nodes[i].m_x);
 		normals[i] = convert(softbody->m_nodes[i].m_n);
 	}
+	if (interpolate)
+		for (int i = 0, n = vertices.size(); i < n; i++)
+			vertices[i] = glm::mix(previousVertices[i], vertices[i], alpha);
+
+	Upload();
+}
 
+void SoftBody::Update(const std::vector<glm::vec3>& previous,
+	const std::vector<glm::vec3>& current,
+	const std::vector<glm::vec3>& currentNormals, float alpha)
+{
+	if (current.empty())
+		return;
+	vertices = current;
+	normals = currentNormals;
+	if (alpha < 1.f && previous.size() == current.size())
+		for (int i = 0, n = vertices.size(); i < n; i++)
+			vertices[i] = glm::mix(previous[i], current[i], alpha);
+
+	Upload();
+}
+
+void SoftBody::Upload()
+{
+	UploadBuffers(vertices, normals);
+}
+
+void SoftBody::UploadBuffers(const std::vector<glm::vec3>& p_vertices,
+	const std::vector<glm::vec3>& p_normals)
+{
+	if (!VBOs)
+		return;
 	glBindBuffer(GL_ARRAY_BUFFER, VBOs[0]);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), &vertices[0], GL_STREAM_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, p_vertices.size() * sizeof(glm::vec3), &p_vertices[0], GL_STREAM_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, VBOs[1]);
-	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), &normals[0], GL_STREAM_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, p_normals.size() * sizeof(glm::vec3), &p_normals[0], GL_STREAM_DRAW);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void SoftBody::SetIndices(const std::vector<unsigned int>& p_indices)
+{
+	indices = p_indices;
+	if (!VBOs)
+		return;
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	glBindVertexArray(0);
+}
+
 void SoftBody::Render()
 {
 	glBindVertexArray(vao);
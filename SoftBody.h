@@ -13,13 +13,20 @@
 
 class SoftBody
 {
-	private:
+	protected:
+		// Sends vertices and normals to the GPU. Bodies rendering a
+		// different mesh to the one they simulate override it.
+		virtual void Upload();
+		void UploadBuffers(const std::vector<glm::vec3>& p_vertices,
+			const std::vector<glm::vec3>& p_normals);
+		// Replaces the faces rendered
+		void SetIndices(const std::vector<unsigned int>& p_indices);
 
 	public:
 
-		GLuint vao;
-		GLuint *VBOs;
-		GLuint IBO;
+		GLuint vao = 0;
+		GLuint *VBOs = nullptr;
+		GLuint IBO = 0;
 
 		glm::vec4 color;
 
@@ -28,11 +35,21 @@ class SoftBody
 		std::vector<glm::vec3> vertices;
 		std::vector<glm::vec3> normals;
 		std::vector<unsigned int> indices;
-
-		SoftBody(btSoftBody* p_softBody);
-		~SoftBody();
-
-		void Update();
+		// Node positions before the last simulation tick
+		std::vector<glm::vec3> previousVertices;
+
+		// Without meshes nothing is sent to the GPU, so no GL context is
+		// needed either, as for benches
+		SoftBody(btSoftBody* p_softBody, bool meshes = true);
+		virtual ~SoftBody();
+
+		void SaveState();
+		// Uploads the nodes interpolated between the last two ticks
+		void Update(float alpha = 1.f);
+		// Uploads vertices captured elsewhere, e.g. on the simulation thread
+		void Update(const std::vector<glm::vec3>& previous,
+			const std::vector<glm::vec3>& current,
+			const std::vector<glm::vec3>& currentNormals, float alpha);
 		void Render();
 		void RenderPatches();
 };
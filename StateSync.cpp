@@ -0,0 +1,218 @@
+#include "StateSync.h"
+#include "PacketTypes.h"
+#include <algorithm>
+#include <cmath>
+
+static int16_t Quantise(float v, float extent)
+{
+	float q = std::round(v / extent * 32767.f);
+	return (int16_t)std::max(-32767.f, std::min(32767.f, q));
+}
+
+static float Dequantise(int16_t q, float extent)
+{
+	return (float)q * extent / 32767.f;
+}
+
+static void WriteObject(const SyncState::Object& o, ByteWriter& out)
+{
+	for (int i = 0; i < 3; i++)
+		out.PutFloat(o.Position[i]);
+	for (int i = 0; i < 4; i++)
+		out.PutInt16(o.Rotation[i]);
+	for (int i = 0; i < 4; i++)
+		out.PutByte(o.Color[i]);
+}
+
+static void ReadObject(SyncState::Object& o, ByteReader& in)
+{
+	for (int i = 0; i < 3; i++)
+		o.Position[i] = in.GetFloat();
+	for (int i = 0; i < 4; i++)
+		o.Rotation[i] = in.GetInt16();
+	for (int i = 0; i < 4; i++)
+		o.Color[i] = in.GetByte();
+}
+
+bool SyncState::Object::operator==(const Object& other) const
+{
+	return memcmp(this, &other, sizeof(Object)) == 0;
+}
+
+void SyncState::Capture(uint32_t tick, const SimulationSnapshot& snapshot,
+	Level *level)
+{
+	Tick = tick;
+	Valid = true;
+	LevelName = level->Name;
+	LevelLayout = level->Layout();
+
+	glm::vec3 c = snapshot.Centroid;
+	for (int i = 0; i < 3; i++)
+		Centroid[i] = c[i];
+
+	Nodes.resize(snapshot.Vertices.size() * 3);
+	for (std::size_t i = 0, n = snapshot.Vertices.size(); i < n; i++)
+	{
+		glm::vec3 offset = snapshot.Vertices[i] - c;
+		for (int j = 0; j < 3; j++)
+			Nodes[i * 3 + j] = Quantise(offset[j], STATE_BLOB_EXTENT);
+	}
+
+	Objects.resize(snapshot.Objects.size());
+	for (std::size_t i = 0, n = Objects.size(); i < n; i++)
+	{
+		const SimulationSnapshot::Object& ent = snapshot.Objects[i];
+		Object& o = Objects[i];
+		for (int j = 0; j < 3; j++)
+			o.Position[j] = ent.Position[j];
+		for (int j = 0; j < 4; j++)
+			o.Rotation[j] = Quantise(ent.Rotation[j], 1.f);
+		for (int j = 0; j < 4; j++)
+			o.Color[j] = (uint8_t)(glm::clamp(ent.Color[j], 0.f, 1.f) * 255.f);
+	}
+}
+
+void SyncState::Apply(Blob *blob, Level *level) const
+{
+	btSoftBody *sb = blob->softbody;
+	if (Nodes.size() == (std::size_t)sb->m_nodes.size() * 3)
+	{
+		btVector3 c(Centroid[0], Centroid[1], Centroid[2]);
+		for (int i = 0, n = sb->m_nodes.size(); i < n; i++)
+			sb->m_nodes[i].m_x = c + btVector3(
+				Dequantise(Nodes[i * 3], STATE_BLOB_EXTENT),
+				Dequantise(Nodes[i * 3 + 1], STATE_BLOB_EXTENT),
+				Dequantise(Nodes[i * 3 + 2], STATE_BLOB_EXTENT));
+		sb->updateNormals();
+	}
+
+	std::size_t n = std::min(Objects.size(), level->Objects.size());
+	for (std::size_t i = 0; i < n; i++)
+	{
+		const Object& o = Objects[i];
+		GameObject *ent = level->Objects[i];
+		glm::quat rotation(
+			Dequantise(o.Rotation[3], 1.f), Dequantise(o.Rotation[0], 1.f),
+			Dequantise(o.Rotation[1], 1.f), Dequantise(o.Rotation[2], 1.f));
+		ent->rigidbody->setWorldTransform(btTransform(
+			convert(glm::normalize(rotation)),
+			btVector3(o.Position[0], o.Position[1], o.Position[2])));
+		ent->color = glm::vec4(o.Color[0], o.Color[1], o.Color[2],
+			o.Color[3]) / 255.f;
+	}
+}
+
+void SyncState::WriteKeyframe(ByteWriter& out) const
+{
+	out.PutByte(ID_BLOB_STATE);
+	out.PutByte(Keyframe);
+	out.PutVarUInt(Tick);
+	out.PutString(LevelName);
+	out.PutVarUInt(LevelLayout);
+	for (int i = 0; i < 3; i++)
+		out.PutFloat(Centroid[i]);
+	out.PutVarUInt(Nodes.size());
+	for (int16_t q : Nodes)
+		out.PutVarInt(q);
+	out.PutVarUInt(Objects.size());
+	for (const Object& o : Objects)
+		WriteObject(o, out);
+}
+
+void SyncState::WriteDelta(const SyncState& base, ByteWriter& out) const
+{
+	out.PutByte(ID_BLOB_STATE);
+	out.PutByte(Delta);
+	out.PutVarUInt(Tick);
+	out.PutVarUInt(base.Tick);
+	for (int i = 0; i < 3; i++)
+		out.PutFloat(Centroid[i]);
+	for (std::size_t i = 0, n = Nodes.size(); i < n; i++)
+		out.PutVarInt(Nodes[i] - base.Nodes[i]);
+
+	std::vector<uint32_t> changed;
+	for (std::size_t i = 0, n = Objects.size(); i < n; i++)
+		if (!(Objects[i] == base.Objects[i]))
+			changed.push_back(i);
+	out.PutVarUInt(changed.size());
+	for (uint32_t i : changed)
+	{
+		out.PutVarUInt(i);
+		WriteObject(Objects[i], out);
+	}
+}
+
+bool SyncState::Read(ByteReader& in)
+{
+	if (in.GetByte() != ID_BLOB_STATE)
+		return false;
+	uint8_t kind = in.GetByte();
+	uint32_t tick = in.GetVarUInt();
+
+	if (kind == Keyframe)
+	{
+		LevelName = in.GetString(STATE_LEVEL_NAME_LENGTH);
+		LevelLayout = in.GetVarUInt();
+		for (int i = 0; i < 3; i++)
+			Centroid[i] = in.GetFloat();
+		Nodes.resize(std::min(in.GetVarUInt(), (uint32_t)1 << 20));
+		for (int16_t& q : Nodes)
+			q = (int16_t)in.GetVarInt();
+		Objects.resize(std::min(in.GetVarUInt(), (uint32_t)1 << 16));
+		for (Object& o : Objects)
+			ReadObject(o, in);
+	}
+	else
+	{
+		// Deltas only apply on top of the tick they were made against
+		uint32_t base = in.GetVarUInt();
+		if (!Valid || base != Tick)
+			return false;
+		for (int i = 0; i < 3; i++)
+			Centroid[i] = in.GetFloat();
+		for (int16_t& q : Nodes)
+			q = (int16_t)(q + in.GetVarInt());
+		for (uint32_t i = 0, n = in.GetVarUInt(); i < n && in.Good(); i++)
+		{
+			uint32_t index = in.GetVarUInt();
+			Object o;
+			ReadObject(o, in);
+			if (index < Objects.size())
+				Objects[index] = o;
+		}
+	}
+
+	Valid = in.Good();
+	Tick = tick;
+	return Valid;
+}
+
+void StateEncoder::Encode(uint32_t tick, const SimulationSnapshot& snapshot,
+	Level *level, ByteWriter& delta, ByteWriter& keyframe, bool wantKeyframe)
+{
+	std::swap(current, previous);
+	current.Capture(tick, snapshot, level);
+	// Deltas can't say the level changed, so a new one needs a keyframe
+	if (previous.Valid && previous.Nodes.size() == current.Nodes.size()
+		&& previous.Objects.size() == current.Objects.size()
+		&& previous.LevelLayout == current.LevelLayout
+		&& previous.LevelName == current.LevelName)
+	{
+		current.WriteDelta(previous, delta);
+		bytes += delta.Data.size();
+	}
+	if (wantKeyframe || delta.Data.empty())
+		current.WriteKeyframe(keyframe);
+}
+
+void StateEncoder::Update(double deltaTime)
+{
+	elapsed += deltaTime;
+	if (elapsed >= 1.0)
+	{
+		BytesPerViewer = bytes / elapsed;
+		bytes = 0;
+		elapsed = 0.0;
+	}
+}
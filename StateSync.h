@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ByteStream.h"
+#include "Blob.h"
+#include "Level.h"
+#include "SimulationThread.h"
+
+// Simulation state for viewers that render locally instead of decoding
+// the video stream. Blob nodes are quantised relative to the centroid and
+// sent as zigzag varint deltas against the previous tick; objects are only
+// sent when their transform or colour changed. Keyframes name the level and
+// its layout, which a viewer's copy has to match.
+struct SyncState
+{
+	struct Object
+	{
+		float Position[3];
+		int16_t Rotation[4];
+		uint8_t Color[4];
+
+		bool operator==(const Object& other) const;
+	};
+
+	uint32_t Tick = 0;
+	bool Valid = false;
+	std::string LevelName;
+	uint32_t LevelLayout = 0;
+	float Centroid[3];
+	std::vector<int16_t> Nodes;
+	std::vector<Object> Objects;
+
+	// Main thread, with the level the snapshot was taken of
+	void Capture(uint32_t tick, const SimulationSnapshot& snapshot,
+		Level *level);
+	void Apply(Blob *blob, Level *level) const;
+	void WriteKeyframe(ByteWriter& out) const;
+	void WriteDelta(const SyncState& base, ByteWriter& out) const;
+	bool Read(ByteReader& in);
+
+	enum Kind : uint8_t { Keyframe, Delta };
+};
+
+class StateEncoder
+{
+	public:
+		double BytesPerViewer = 0.0;
+
+		// Returns the delta for existing viewers and, if wanted or no delta
+		// could be made, the keyframe for new ones, both describing the same
+		// tick
+		void Encode(uint32_t tick, const SimulationSnapshot& snapshot,
+			Level *level, ByteWriter& delta, ByteWriter& keyframe,
+			bool wantKeyframe);
+		void Update(double deltaTime);
+
+	private:
+		SyncState current;
+		SyncState previous;
+		std::size_t bytes = 0;
+		double elapsed = 0.0;
+};
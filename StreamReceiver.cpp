@@ -1,5 +1,6 @@
 #include "StreamReceiver.h"
 #include "config.h"
+#include "FrameStamp.h"
 #include <exception>
 
 StreamReceiver::StreamReceiver(
@@ -46,19 +47,29 @@ StreamReceiver::~StreamReceiver()
 	av_frame_free(&avframe);
 }
 
-void StreamReceiver::ReceiveFrame(uint8_t *data)
+bool StreamReceiver::ReceiveFrame(uint8_t *data)
 {
 	AVPacket *pkt = av_packet_alloc();
 	av_init_packet(pkt);
 	if (av_read_frame(avfmt, pkt) < 0)
-		return;
+		return false;
+	uint32_t frame_id, capture_time;
+	bool stamped = FrameStamp::Find(
+			pkt->data, pkt->size, frame_id, capture_time);
 	int got_picture;
 	if (avcodec_decode_video2(avctx, avframe, &got_picture, pkt) < 0)
-		return;
+		return false;
 	av_packet_unref(pkt);
 	av_packet_free(&pkt);
 	if (got_picture == 0)
-		return;
+		return false;
+
+	HasFrameID = stamped;
+	if (stamped)
+	{
+		FrameID = frame_id;
+		FrameCaptureTime = capture_time;
+	}
 
 	int linesize_align[AV_NUM_DATA_POINTERS];
 	avcodec_align_dimensions2(
@@ -73,4 +84,5 @@ void StreamReceiver::ReceiveFrame(uint8_t *data)
 				0, STREAM_HEIGHT,
 				dstSlice, dstStride);
 	av_frame_unref(avframe);
+	return true;
 }
@@ -16,7 +16,12 @@ class StreamReceiver
 		StreamReceiver& operator=(const StreamReceiver&) = delete;
 		StreamReceiver(StreamReceiver&& other) = default;
 		StreamReceiver& operator=(StreamReceiver&& other) = default;
-		void ReceiveFrame(uint8_t *data);
+		bool ReceiveFrame(uint8_t *data);
+
+		// Stamp of the last decoded frame, if the server tagged it
+		bool HasFrameID = false;
+		uint32_t FrameID = 0;
+		uint32_t FrameCaptureTime = 0;
 
 	private:
 		AVFormatContext *avfmt = nullptr;
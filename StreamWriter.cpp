@@ -1,14 +1,19 @@
 #include "StreamWriter.h"
 #include "config.h"
+#include "FrameStamp.h"
 #include <vector>
 #include <string>
 #include <exception>
+#include <cstring>
 
 StreamWriter::StreamWriter(
-		int viewportWidth, int viewportHeight, int num_buffers) :
+		int viewportWidth, int viewportHeight, int num_buffers,
+		const std::string& path) :
 	width(viewportWidth), height(viewportHeight), numPBOs(num_buffers)
 {
 	pbo = new GLuint[num_buffers];
+	pboFrameIDs = new uint32_t[num_buffers];
+	pboCaptureTimes = new double[num_buffers];
 	glGenBuffers(num_buffers, pbo);
 	avcodec_register_all();
 	AVDictionary *opts = nullptr;
@@ -59,7 +64,7 @@ StreamWriter::StreamWriter(
 	av_register_all();
 	avformat_network_init();
 	avfmt = avformat_alloc_context();
-	std::string filename = STREAM_PATH;
+	std::string filename = path;
 	avfmt->oformat = av_guess_format("flv", 0, 0);
 	av_dict_set(&opts, "live", "1", 0);
 	filename.copy(avfmt->filename, filename.size(), 0);
@@ -95,11 +100,15 @@ StreamWriter::~StreamWriter()
 	//avcodec_free_context(&avctx);
 	av_frame_free(&avframe);
 	delete[] pbo;
+	delete[] pboFrameIDs;
+	delete[] pboCaptureTimes;
 }
 
-void StreamWriter::WriteFrame()
+bool StreamWriter::WriteFrame(uint32_t frameID, double captureTime)
 {
 	int buf_index = frame % numPBOs;
+	uint32_t encode_id = pboFrameIDs[buf_index];
+	double encode_time = pboCaptureTimes[buf_index];
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[buf_index]);
 	if (frame >= numPBOs)
 	{
@@ -118,6 +127,10 @@ void StreamWriter::WriteFrame()
 	}
 	glReadPixels(0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	pboFrameIDs[buf_index] = frameID;
+	pboCaptureTimes[buf_index] = captureTime;
+
+	bool encoded = false;
 	if (frame >= numPBOs)
 	{
 		AVPacket *avpkt = av_packet_alloc();
@@ -125,10 +138,27 @@ void StreamWriter::WriteFrame()
 		if (avcodec_encode_video2(avctx, avpkt, avframe, &got_packet) < 0)
 			exit(1);
 		if (got_packet == 1)
+		{
+			// Tag the access unit so clients can echo what they display
+			std::vector<uint8_t> sei = FrameStamp::CreateNAL(
+				encode_id, (uint32_t)(encode_time * 1000.0));
+			int size = avpkt->size;
+			int offset = FrameStamp::FirstSliceOffset(avpkt->data, size);
+			if (av_grow_packet(avpkt, sei.size()) == 0)
+			{
+				memmove(avpkt->data + offset + sei.size(),
+					avpkt->data + offset, size - offset);
+				memcpy(avpkt->data + offset, sei.data(), sei.size());
+			}
+			BytesWritten += avpkt->size;
 			av_interleaved_write_frame(avfmt, avpkt);
+			EncodedFrameID = encode_id;
+			encoded = true;
+		}
 		av_packet_free(&avpkt);
 	}
 	frame++;
+	return encoded;
 }
 
 void StreamWriter::Close()
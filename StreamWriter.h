@@ -1,5 +1,8 @@
 #pragma once
 #include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include "config.h"
 extern "C"
 {
 #include <libavcodec/avcodec.h>
@@ -12,22 +15,28 @@ class StreamWriter
 {
 	public:
 		StreamWriter(
-				int viewportWidth, int viewportHeight, int num_buffers = 1);
+				int viewportWidth, int viewportHeight, int num_buffers = 1,
+				const std::string& path = STREAM_PATH);
 		~StreamWriter();
 		StreamWriter(const StreamWriter&) = delete;
 		StreamWriter& operator=(const StreamWriter&) = delete;
 		StreamWriter(StreamWriter&& other) = default;
 		StreamWriter& operator=(StreamWriter&& other) = default;
-		void WriteFrame();
+		bool WriteFrame(uint32_t frameID = 0, double captureTime = 0.0);
 		void Close();
 		bool IsOpen() const;
 
+		uint32_t EncodedFrameID = 0;
+		uint64_t BytesWritten = 0;
+
 	private:
 		AVFrame *avframe;
 		AVCodecContext *avctx;
 		AVFormatContext *avfmt;
 		SwsContext *swctx;
 		GLuint *pbo;
+		uint32_t *pboFrameIDs;
+		double *pboCaptureTimes;
 		int width;
 		int height;
 		int numPBOs;
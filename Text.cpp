@@ -17,7 +17,6 @@ void Text::SetText(std::string text)
 	float pen_y = YPosition;
 
 	std::size_t length = text.size();
-	NumVerts = length * 6;
 	std::vector<GLfloat> vertices;
 	std::vector<GLfloat> texcoords;
 
@@ -27,11 +26,18 @@ void Text::SetText(std::string text)
 		if ((text[i] & 0xC0) == 0x80)
 			continue;
 
+		if (text[i] == '\n')
+		{
+			pen_x = XPosition;
+			pen_y -= LineHeight();
+			continue;
+		}
+
 		texture_glyph_t *glyph = FontStyle->GetGlyph(&text[i]);
 		if (glyph != NULL)
 		{
 			float kerning = 0.f;
-			if (i > 0)
+			if (i > 0 && text[i - 1] != '\n')
 			{
 				kerning = FontStyle->GetKerning(glyph, &text[i - 1]);
 			}
@@ -64,6 +70,11 @@ void Text::SetText(std::string text)
 		}
 	}
 
+	// Skipped bytes and missing glyphs have no vertices
+	NumVerts = vertices.size() / 2;
+	if (NumVerts == 0)
+		return;
+
 	Vertices = FloatBuffer(&VAO, 2, NumVerts);
 	Vertices.SetData(&vertices[0]);
 	TexCoords = FloatBuffer(&VAO, 2, NumVerts);
@@ -71,3 +82,8 @@ void Text::SetText(std::string text)
 	Vertices.VertexAttribPointer(0);
 	TexCoords.VertexAttribPointer(1);
 }
+
+float Text::LineHeight() const
+{
+	return FontStyle->TextureFont->height;
+}
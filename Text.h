@@ -20,5 +20,7 @@ class Text
 
 		Text(Font *font);
 		void Draw() const;
+		// Lines after a newline start one LineHeight below the last
 		void SetText(std::string text);
+		float LineHeight() const;
 };
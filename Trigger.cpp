@@ -20,20 +20,20 @@ void Trigger::RegisterCallback(CallbackFunc callback, CallbackType type)
 
 void Trigger::OnEnter()
 {
-	for (auto callback : onEnterCallbacks)
+	for (const CallbackFunc& callback : onEnterCallbacks)
 		callback();
 	bTriggered = true;
 }
 
 void Trigger::OnStay()
 {
-	for (auto callback : onStayCallbacks)
+	for (const CallbackFunc& callback : onStayCallbacks)
 		callback();
 }
 
 void Trigger::OnLeave()
 {
-	for (auto callback : onLeaveCallbacks)
+	for (const CallbackFunc& callback : onLeaveCallbacks)
 		callback();
 	bTriggered = false;
 }
@@ -0,0 +1,136 @@
+#ifdef __linux__
+
+#include "UdpInputEndpoint.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <cstring>
+
+UdpInputEndpoint::UdpInputEndpoint(NetworkThread *network) :
+	network(network),
+	rng(std::random_device{}())
+{ }
+
+UdpInputEndpoint::~UdpInputEndpoint()
+{
+	Stop();
+}
+
+bool UdpInputEndpoint::Start(unsigned short port)
+{
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		return false;
+
+	int buffer = UDP_INPUT_SOCKET_BUFFER;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+	// Wake up now and then to notice Stop()
+	timeval timeout = { 0, 100000 };
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (bind(fd, (sockaddr *)&address, sizeof(address)) < 0)
+	{
+		close(fd);
+		fd = -1;
+		return false;
+	}
+
+	running = true;
+	thread = std::thread(&UdpInputEndpoint::Run, this);
+	return true;
+}
+
+void UdpInputEndpoint::Stop()
+{
+	running = false;
+	if (thread.joinable())
+		thread.join();
+	if (fd >= 0)
+		close(fd);
+	fd = -1;
+}
+
+uint64_t UdpInputEndpoint::AddSession(RakNet::RakNetGUID client)
+{
+	std::lock_guard<std::mutex> lock(sessionMutex);
+	uint64_t token;
+	do
+		token = rng();
+	while (token == 0 || sessions.count(token));
+	sessions[token] = { client, 0, false };
+	tokens[client.g] = token;
+	return token;
+}
+
+void UdpInputEndpoint::RemoveSession(RakNet::RakNetGUID client)
+{
+	std::lock_guard<std::mutex> lock(sessionMutex);
+	auto it = tokens.find(client.g);
+	if (it == tokens.end())
+		return;
+	sessions.erase(it->second);
+	tokens.erase(it);
+}
+
+void UdpInputEndpoint::Run()
+{
+	// Room for one input packet and a byte more, so longer datagrams are
+	// recognisable by their length
+	const int size = sizeof(UdpInputPacket) + 1;
+	unsigned char buffers[UDP_INPUT_BATCH][size];
+	iovec iovecs[UDP_INPUT_BATCH];
+	mmsghdr messages[UDP_INPUT_BATCH];
+	std::memset(messages, 0, sizeof(messages));
+	for (int i = 0; i < UDP_INPUT_BATCH; i++)
+	{
+		iovecs[i].iov_base = buffers[i];
+		iovecs[i].iov_len = size;
+		messages[i].msg_hdr.msg_iov = &iovecs[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (running)
+	{
+		int count = recvmmsg(fd, messages, UDP_INPUT_BATCH, MSG_WAITFORONE,
+			nullptr);
+		if (count <= 0)
+			continue;
+
+		int accepted = 0;
+		std::lock_guard<std::mutex> lock(sessionMutex);
+		for (int i = 0; i < count; i++)
+		{
+			if (messages[i].msg_len != sizeof(UdpInputPacket))
+				continue;
+			UdpInputPacket packet;
+			std::memcpy(&packet, buffers[i], sizeof(packet));
+
+			auto it = sessions.find(packet.Token);
+			if (it == sessions.end())
+				continue;
+
+			// Drop datagrams older than the newest one seen
+			Session& session = it->second;
+			if (session.Started
+				&& (int16_t)(packet.Sequence - session.Sequence) <= 0)
+				continue;
+			session.Sequence = packet.Sequence;
+			session.Started = true;
+
+			InputEvent e = { session.Client, (BlobInput)(packet.Input & 0x1F) };
+			if (!network->Inputs.Push(e))
+				network->DroppedInputs++;
+			accepted++;
+		}
+		Received += accepted;
+		Rejected += count - accepted;
+		network->InputPackets += accepted;
+	}
+}
+
+#endif // __linux__
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <RakNet/RakNetTypes.h>
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <cstdint>
+
+#include "NetworkThread.h"
+#include "config.h"
+
+// Input datagram: session token, sequence number, input
+#pragma pack(push, 1)
+struct UdpInputPacket
+{
+	uint64_t Token;
+	uint16_t Sequence;
+	uint8_t Input;
+};
+#pragma pack(pop)
+
+// Lightweight input path next to RakNet. Clients get a session token over
+// their RakNet connection and then send bare datagrams, which are read in
+// batches with recvmmsg into preallocated buffers and pushed straight into
+// the network thread's input queue.
+class UdpInputEndpoint
+{
+	public:
+		UdpInputEndpoint(NetworkThread *network);
+		~UdpInputEndpoint();
+		UdpInputEndpoint(const UdpInputEndpoint&) = delete;
+		UdpInputEndpoint& operator=(const UdpInputEndpoint&) = delete;
+
+		bool Start(unsigned short port);
+		void Stop();
+
+		// Main thread
+		uint64_t AddSession(RakNet::RakNetGUID client);
+		void RemoveSession(RakNet::RakNetGUID client);
+
+		std::atomic<uint64_t> Received{ 0 };
+		std::atomic<uint64_t> Rejected{ 0 };
+
+	private:
+		struct Session
+		{
+			RakNet::RakNetGUID Client;
+			uint16_t Sequence;
+			bool Started;
+		};
+
+		NetworkThread *network;
+		int fd = -1;
+		std::thread thread;
+		std::atomic<bool> running{ false };
+
+		std::mutex sessionMutex;
+		std::unordered_map<uint64_t, Session> sessions;
+		std::unordered_map<uint64_t, uint64_t> tokens;
+		std::mt19937_64 rng;
+
+		void Run();
+};
+
+#endif // __linux__
@@ -0,0 +1,71 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int threads)
+{
+	for (int i = 1; i < threads; i++)
+		workers.push_back(std::thread(&WorkerPool::Work, this, i));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	started.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void WorkerPool::Run(int count, const RangeFunc& func)
+{
+	int shares = Threads();
+	if (shares == 1 || count < shares)
+	{
+		func(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &func;
+		jobCount = count;
+		pending = shares - 1;
+		generation++;
+	}
+	started.notify_all();
+
+	func(0, count / shares);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this]() { return pending == 0; });
+	job = nullptr;
+}
+
+void WorkerPool::Work(int share)
+{
+	uint64_t seen = 0;
+	while (true)
+	{
+		const RangeFunc *func;
+		int count;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			started.wait(lock, [&]() {
+				return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+			func = job;
+			count = jobCount;
+		}
+
+		int shares = Threads();
+		(*func)((int)((int64_t)count * share / shares),
+			(int)((int64_t)count * (share + 1) / shares));
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--pending == 0)
+			finished.notify_one();
+	}
+}
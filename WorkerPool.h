@@ -0,0 +1,38 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Splits one loop at a time across a fixed set of threads. The calling
+// thread takes the first share, and Run returns once every share is done.
+class WorkerPool
+{
+	public:
+		typedef std::function<void(int begin, int end)> RangeFunc;
+
+		// Counts the calling thread, so 1 runs everything inline
+		WorkerPool(int threads);
+		~WorkerPool();
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		int Threads() const { return (int)workers.size() + 1; }
+		void Run(int count, const RangeFunc& func);
+
+	private:
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable started;
+		std::condition_variable finished;
+
+		const RangeFunc *job = nullptr;
+		int jobCount = 0;
+		int pending = 0;
+		uint64_t generation = 0;
+		bool stopping = false;
+
+		void Work(int share);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Each benchmark is run by name from the command line and prints its own
+// table. Anything after the name is passed through as arguments.
+typedef int (*BenchFunc)(const std::vector<std::string>& args);
+
+struct Bench
+{
+	const char *Name;
+	const char *Usage;
+	BenchFunc Run;
+};
+
+// Seconds per call of f, the best of a few runs of reps calls each
+template <typename F>
+double TimeBest(F f, int reps, int runs = 5)
+{
+	typedef std::chrono::steady_clock clock;
+	double best = 1e30;
+	for (int r = 0; r < runs; r++)
+	{
+		clock::time_point start = clock::now();
+		for (int i = 0; i < reps; i++)
+			f();
+		double elapsed = std::chrono::duration<double>(
+			clock::now() - start).count();
+		best = std::min(best, elapsed / reps);
+	}
+	return best;
+}
+
+// Numeric arguments in order, or the defaults if none were given
+inline std::vector<int> IntArgs(const std::vector<std::string>& args,
+	std::vector<int> defaults)
+{
+	if (args.empty())
+		return defaults;
+	std::vector<int> values;
+	for (const std::string& arg : args)
+		values.push_back(std::stoi(arg));
+	return values;
+}
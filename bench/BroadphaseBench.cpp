@@ -0,0 +1,289 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+
+#include "Blob.h"
+#include "GameObject.h"
+#include "Level.h"
+#include "Physics.h"
+
+#include "Bench.h"
+#include "ProfileTime.h"
+#include "config.h"
+
+// Server ticks on each level under each broadphase, with the blob dropped
+// in where it spawns. Levels are loaded as the server loads them, baked if
+// they say so. Numbers stand for stress levels of that many dynamic boxes,
+// a tenth as many movers, and a floor. The blob's solve dominates a tick on
+// small levels, so the broadphase's own share is taken from Bullet's
+// profiler, and the broadphase fastest there is what a level's "broadphase"
+// should say.
+//
+// The bake bench runs the same ticks on each level's own broadphase with
+// its static scenery unbaked and then baked, and times building the baked
+// mesh's BVH against loading it from BakeCacheDir. There, numbers stand for
+// stress levels of that many static boxes and cylinders, plus a tenth as
+// many dynamic boxes. Baking is only worth a level's "bake" where the whole
+// tick gets faster, as the blob collides slower with triangles than with
+// boxes.
+
+namespace
+{
+	const int ticks = 300;
+	const int runs = 3;
+
+	const char *defaultLevels[] = {
+		"level.json", "level1.json", "leveltest.json", "test2.json",
+		"test_level.json", "500", "2000"
+	};
+
+	const char *defaultBakeLevels[] = {
+		"level.json", "level1.json", "leveltest.json", "test2.json",
+		"test_level.json", "1000", "4000"
+	};
+
+	// Static scenery for the bake bench: boxes and cylinders in a grid
+	void AddStatics(Level *level, int statics)
+	{
+		int side = (int)std::ceil(std::sqrt((float)statics));
+		for (int i = 0; i < statics; i++)
+		{
+			glm::vec3 position((i % side) * 4.f - side * 2.f, 0.5f,
+				(i / side) * 4.f - side * 2.f);
+			level->AddGameObject(position, glm::quat(),
+				glm::vec3(1.f, 0.5f + (i % 3) * 0.5f, 1.f), glm::vec4(1), 0,
+				i % 2 ? "box" : "cylinder");
+		}
+	}
+
+	Level* StressLevel(int boxes, int statics = 0)
+	{
+		Level *level = new Level(false);
+		std::mt19937 rng(boxes);
+		std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+		int side = (int)std::ceil(std::sqrt((float)boxes));
+		float extent = side * 3.f;
+		level->AddGameObject(glm::vec3(0, -1, 0), glm::quat(),
+			glm::vec3(extent, 1, extent), glm::vec4(1), 0, "box");
+		for (int i = 0; i < boxes; i++)
+		{
+			glm::vec3 position((i % side) * 6.f - extent + jitter(rng),
+				2.f + (i / side) % 4, (i / side) * 6.f - extent);
+			level->AddGameObject(position, glm::quat(), glm::vec3(0.5f),
+				glm::vec4(1), 0, "box", 1.f);
+		}
+		for (int i = 0; i < boxes / 10; i++)
+		{
+			glm::vec3 start((i % side) * 6.f - extent + 3.f, 6.f,
+				(i / side) * 6.f - extent + 3.f);
+			std::size_t index = level->AddGameObject(start, glm::quat(),
+				glm::vec3(1, 0.2f, 1), glm::vec4(1), 0, "box");
+			GameObject *mover = level->Objects[index];
+			mover->motion.Points = { start, start + glm::vec3(0, 0, 6),
+				start + glm::vec3(6, 0, 6) };
+			mover->motion.Speed = 0.05f;
+			mover->motion.Enabled = true;
+			mover->UpdateBody();
+		}
+		AddStatics(level, statics);
+		return level;
+	}
+
+	void Unload(Level *level)
+	{
+		for (GameObject *ent : level->Objects)
+			Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
+		delete level;
+	}
+
+	struct Result
+	{
+		// Milliseconds per tick, all of it and the broadphase's
+		double Tick = 1e30;
+		double Broadphase = 1e30;
+		double Pairs = 0.0;
+	};
+
+	Result Measure(Level *level, Physics::Broadphase type)
+	{
+		level->BroadphaseType = type;
+		level->UseBroadphase();
+		btSoftBody *blob = Blob::CreateSoftBody(Physics::softBodyWorldInfo,
+			btVector3(0, 15, 0), 3.0f, BLOB_NODES);
+		Physics::dynamicsWorld->addSoftBody(blob);
+
+		Result result;
+		result.Tick = result.Broadphase = 0.0;
+		for (int i = 0; i < ticks; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			level->StepPaths();
+			for (GameObject *ent : level->Objects)
+				ent->Update();
+			Physics::dynamicsWorld->stepSimulation(SIMULATION_TIMESTEP, 0);
+			result.Tick += std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+			result.Pairs += Physics::broadphase->getOverlappingPairCache()
+				->getNumOverlappingPairs();
+			// Moving proxies is where the sweep and prune ones sort
+			result.Broadphase += ProfileTime("updateAabbs")
+				+ ProfileTime("calculateOverlappingPairs");
+		}
+		result.Tick /= ticks;
+		result.Broadphase /= ticks;
+		result.Pairs /= ticks;
+
+		Physics::dynamicsWorld->removeSoftBody(blob);
+		delete blob;
+		return result;
+	}
+}
+
+int BroadphaseBench(const std::vector<std::string>& args)
+{
+	std::vector<std::string> levels(args);
+	if (levels.empty())
+		levels.assign(std::begin(defaultLevels), std::end(defaultLevels));
+
+	std::cout << "ms per tick / us of it in the broadphase (pairs)"
+		<< std::endl;
+	std::cout << std::setw(16) << "level" << std::setw(8) << "objects";
+	for (const char *name : Physics::broadphaseNames)
+		std::cout << std::setw(24) << name;
+	std::cout << std::setw(8) << "best" << std::endl;
+
+	Physics::Init();
+	for (const std::string& name : levels)
+	{
+		bool stress = name.find_first_not_of("0123456789") == std::string::npos;
+		int objects = 0;
+		std::vector<Result> results;
+		for (int type = 0; type < (int)Physics::Broadphase::Count; type++)
+		{
+			// Reloaded for every run, so each starts from the same state
+			Result best;
+			for (int run = 0; run < runs; run++)
+			{
+				Level *level = stress ? StressLevel(std::stoi(name)) :
+					Level::Deserialize(LevelDir + name, false);
+				if (!level)
+					break;
+				objects = (int)level->Objects.size();
+				Result result = Measure(level, (Physics::Broadphase)type);
+				Unload(level);
+				best.Tick = std::min(best.Tick, result.Tick);
+				best.Broadphase = std::min(best.Broadphase, result.Broadphase);
+				best.Pairs = result.Pairs;
+			}
+			results.push_back(best);
+		}
+
+		std::cout << std::setw(16) << name;
+		if (objects == 0)
+		{
+			std::cout << "  not found" << std::endl;
+			continue;
+		}
+		std::cout << std::setw(8) << objects;
+		// Within a tenth, or the profiler's microsecond, is a tie, which
+		// goes to the first listed
+		int bestType = 0;
+		for (int type = 0; type < (int)results.size(); type++)
+		{
+			const Result& result = results[type];
+			std::cout << std::fixed << std::setprecision(3) << std::setw(8)
+				<< result.Tick << " /" << std::setprecision(1) << std::setw(6)
+				<< result.Broadphase * 1e3 << " (" << std::setw(5)
+				<< (int)result.Pairs << ")";
+			if (result.Broadphase <
+				std::min(results[bestType].Broadphase * 0.9,
+				results[bestType].Broadphase - 1e-3))
+				bestType = type;
+		}
+		std::cout << std::setw(8) << Physics::broadphaseNames[bestType]
+			<< std::endl;
+	}
+	Physics::Cleanup();
+	return 0;
+}
+
+int BakeBench(const std::vector<std::string>& args)
+{
+	std::vector<std::string> levels(args);
+	if (levels.empty())
+		levels.assign(std::begin(defaultBakeLevels), std::end(defaultBakeLevels));
+
+	std::cout << "ms per tick / us of it in the broadphase (pairs), and ms"
+		" to bake" << std::endl;
+	std::cout << std::setw(16) << "level" << std::setw(8) << "objects"
+		<< std::setw(8) << "baked" << std::setw(24) << "unbaked"
+		<< std::setw(24) << "baked" << std::setw(10) << "build"
+		<< std::setw(10) << "cached" << std::setw(6) << "bake" << std::endl;
+
+	Physics::Init();
+	for (const std::string& name : levels)
+	{
+		bool stress = name.find_first_not_of("0123456789") == std::string::npos;
+		int objects = 0, baked = 0;
+		Result results[2];
+		double build = 1e30, cached = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			for (int bake = 0; bake < 2; bake++)
+			{
+				Level *level = stress ?
+					StressLevel(std::stoi(name) / 10, std::stoi(name)) :
+					Level::Deserialize(LevelDir + name, false);
+				if (!level)
+					break;
+				objects = (int)level->Objects.size();
+				// What the broadphase bench picks for every level so far
+				if (stress)
+					level->BroadphaseType = Physics::Broadphase::Dbvt;
+				level->UseBroadphase();
+				level->Unbake();
+				if (bake)
+				{
+					build = std::min(build, TimeBest([&]()
+					{
+						level->Bake(false);
+					}, 1, 1));
+					level->Unbake();
+					cached = std::min(cached, TimeBest([&]()
+					{
+						level->Bake();
+					}, 1, 1));
+					baked = level->BakedCount();
+				}
+				Result result = Measure(level, level->BroadphaseType);
+				level->Unbake();
+				Unload(level);
+				results[bake].Tick = std::min(results[bake].Tick, result.Tick);
+				results[bake].Broadphase = std::min(results[bake].Broadphase,
+					result.Broadphase);
+				results[bake].Pairs = result.Pairs;
+			}
+		}
+
+		std::cout << std::setw(16) << name;
+		if (objects == 0)
+		{
+			std::cout << "  not found" << std::endl;
+			continue;
+		}
+		std::cout << std::setw(8) << objects << std::setw(8) << baked;
+		for (const Result& result : results)
+			std::cout << std::fixed << std::setprecision(3) << std::setw(8)
+				<< result.Tick << " /" << std::setprecision(1) << std::setw(6)
+				<< result.Broadphase * 1e3 << " (" << std::setw(5)
+				<< (int)result.Pairs << ")";
+		// Within a tenth is a tie, which goes to leaving it unbaked
+		bool worth = results[1].Tick < results[0].Tick * 0.9;
+		std::cout << std::setprecision(3) << std::setw(10) << build * 1e3
+			<< std::setw(10) << cached * 1e3 << std::setw(6)
+			<< (worth ? "yes" : "no") << std::endl;
+	}
+	Physics::Cleanup();
+	return 0;
+}
@@ -0,0 +1,96 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BlobEmbedding.h"
+#include "Helper.h"
+#include "ParallelSoftBodySolver.h"
+#include "SoftWorld.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// A smooth blob two ways, per tick: the coarse body simulated and the fine
+// mesh deformed from it by BlobEmbedding, against the fine mesh simulated
+// directly. Both end with the same fine vertices and normals to draw, so
+// copying them out of the soft body is counted on both sides.
+
+namespace
+{
+	const int settleTicks = 60;
+	const int measureTicks = 100;
+
+	void Gather(btSoftBody *body, std::vector<glm::vec3>& vertices,
+		std::vector<glm::vec3>& normals)
+	{
+		vertices.resize(body->m_nodes.size());
+		normals.resize(vertices.size());
+		for (int i = 0; i < body->m_nodes.size(); i++)
+		{
+			vertices[i] = convert(body->m_nodes[i].m_x);
+			normals[i] = convert(body->m_nodes[i].m_n);
+		}
+	}
+
+	// Milliseconds per tick of stepping, and of producing the vertices
+	void Measure(SoftWorld& world, const BlobEmbedding *embedding,
+		double& step, double& draw)
+	{
+		std::vector<glm::vec3> vertices, normals, fineVertices, fineNormals;
+		world.Step(settleTicks);
+		step = draw = 0.0;
+		for (int i = 0; i < measureTicks; i++)
+		{
+			step += TimeBest([&]() { world.Step(1); }, 1, 1);
+			draw += TimeBest([&]()
+			{
+				Gather(world.Body, vertices, normals);
+				if (embedding)
+					embedding->Deform(vertices, normals, fineVertices,
+						fineNormals);
+			}, 1, 1);
+		}
+		step *= 1e3 / measureTicks;
+		draw *= 1e3 / measureTicks;
+	}
+}
+
+int EmbeddingBench(const std::vector<std::string>& args)
+{
+	std::cout << "ms per tick" << std::endl;
+	std::cout << std::setw(8) << "coarse" << std::setw(8) << "subdiv"
+		<< std::setw(8) << "fine" << std::setw(10) << "step"
+		<< std::setw(10) << "deform" << std::setw(10) << "total"
+		<< std::setw(12) << "fine step" << std::setw(10) << "copy"
+		<< std::setw(10) << "total" << std::setw(10) << "ratio"
+		<< std::endl;
+
+	for (int nodes : IntArgs(args, { 128, 256, BLOB_NODES }))
+	{
+		for (int subdivisions = 1; subdivisions <= 2; subdivisions++)
+		{
+			ParallelSoftBodySolver coarseSolver, fineSolver;
+			SoftWorld coarse(&coarseSolver, nodes, 0);
+			BlobEmbedding embedding(coarse.Body, subdivisions, coarse.Center,
+				coarse.Radius);
+			SoftWorld fine(&fineSolver, nodes, subdivisions);
+
+			double coarseStep, deform, fineStep, copy;
+			Measure(coarse, &embedding, coarseStep, deform);
+			Measure(fine, nullptr, fineStep, copy);
+
+			std::cout << std::setw(8) << coarse.Body->m_nodes.size()
+				<< std::setw(8) << subdivisions << std::setw(8)
+				<< fine.Body->m_nodes.size() << std::fixed
+				<< std::setprecision(3) << std::setw(10) << coarseStep
+				<< std::setw(10) << deform << std::setw(10)
+				<< coarseStep + deform << std::setw(12) << fineStep
+				<< std::setw(10) << copy << std::setw(10) << fineStep + copy
+				<< std::setw(10) << std::setprecision(1)
+				<< (fineStep + copy) / (coarseStep + deform) << std::endl;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include "Blob.h"
+#include "PowInputForces.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// Blob::AddForces' per node work at a given blob size: the pow formulation
+// against Blob::InputForces, including the gather into x and z arrays the
+// kernel needs. Writing the forces to the nodes is the same for both.
+
+int InputForcesBench(const std::vector<std::string>& args)
+{
+	std::cout << std::setw(8) << "nodes" << std::setw(12) << "pow us"
+		<< std::setw(12) << "kernel us" << std::setw(10) << "speedup"
+		<< std::endl;
+
+	for (int n : IntArgs(args, { 512, 2048, 8192 }))
+	{
+		std::mt19937 rng(n);
+		std::uniform_real_distribution<float> offset(-3.f, 3.f);
+		std::vector<btVector3> nodes(n), forces(n);
+		for (btVector3& node : nodes)
+			node = btVector3(offset(rng), offset(rng), offset(rng));
+		const btVector3 forward = btVector3(1, 0, 2).normalized();
+		InputMagnitudes inputs;
+		inputs.Forward = 0.6f;
+		inputs.Right = 0.3f;
+		inputs.BackwardLeft = 0.1f;
+		const float speed = 3.5f;
+
+		double pow = TimeBest([&]()
+		{
+			for (int i = 0; i < n; i++)
+				forces[i] = PowInputForce(nodes[i], forward, inputs, speed);
+		}, 200);
+
+		std::vector<float> x(n), z(n);
+		double kernel = TimeBest([&]()
+		{
+			for (int i = 0; i < n; i++)
+			{
+				x[i] = nodes[i].x();
+				z[i] = nodes[i].z();
+			}
+			Blob::InputForces(x.data(), z.data(), n, forward, inputs, speed);
+		}, 200);
+
+		std::cout << std::setw(8) << n << std::fixed << std::setprecision(2)
+			<< std::setw(12) << pow * 1e6 << std::setw(12) << kernel * 1e6
+			<< std::setw(10) << pow / kernel << std::endl;
+	}
+	return 0;
+}
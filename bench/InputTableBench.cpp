@@ -0,0 +1,102 @@
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "AggregateInput.h"
+#include "InputTable.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// One network thread tick at a given player count: every player's input
+// is applied, then the held inputs are expired and counted. The packed
+// InputTable is compared against the std::map it replaced.
+
+namespace
+{
+	struct HeldInput
+	{
+		BlobInput Input;
+		double LastSeen;
+	};
+
+	struct Tick
+	{
+		std::vector<RakNet::RakNetGUID> Clients;
+		std::vector<BlobInput> Inputs;
+	};
+
+	Tick MakeTick(int players)
+	{
+		std::mt19937 rng(players);
+		Tick tick;
+		for (int i = 0; i < players; i++)
+		{
+			tick.Clients.push_back(RakNet::RakNetGUID(rng()));
+			tick.Inputs.push_back((BlobInput)(rng() % (Jump + 1)));
+		}
+		return tick;
+	}
+}
+
+int InputTableBench(const std::vector<std::string>& args)
+{
+	std::cout << std::setw(10) << "players" << std::setw(14) << "map us"
+		<< std::setw(14) << "table us" << std::setw(10) << "speedup"
+		<< std::setw(8) << "votes" << std::endl;
+
+	for (int players : IntArgs(args, { 100, 1000, 10000 }))
+	{
+		Tick tick = MakeTick(players);
+		double time = 0.0;
+		AggregateInput mapVotes, tableVotes;
+
+		std::map<RakNet::RakNetGUID, HeldInput> held;
+		double map = TimeBest([&]()
+		{
+			time += 1.0 / 60.0;
+			for (int i = 0; i < players; i++)
+				held[tick.Clients[i]] = { tick.Inputs[i], time };
+
+			mapVotes = AggregateInput();
+			for (auto it = held.begin(); it != held.end();)
+			{
+				if (time - it->second.LastSeen > INPUT_TIMEOUT)
+				{
+					it = held.erase(it);
+					continue;
+				}
+				mapVotes += it->second.Input;
+				++it;
+			}
+		}, 100);
+
+		InputTable table(std::max(players, INPUT_SLOTS));
+		double packed = TimeBest([&]()
+		{
+			time += 1.0 / 60.0;
+			for (int i = 0; i < players; i++)
+			{
+				bool added;
+				int slot = table.Acquire(tick.Clients[i], time, added);
+				table.Inputs[slot] = tick.Inputs[i];
+				table.LastSeen[slot] = time;
+			}
+
+			table.Expire(time, INPUT_TIMEOUT);
+			tableVotes = AggregateInput();
+			tableVotes.Add(table.Inputs.data(), table.Count());
+		}, 100);
+
+		std::cout << std::setw(10) << players
+			<< std::setw(14) << std::fixed << std::setprecision(2) << map * 1e6
+			<< std::setw(14) << packed * 1e6
+			<< std::setw(10) << std::setprecision(1) << map / packed
+			<< std::setw(8) << (mapVotes.TotalCount == tableVotes.TotalCount
+				&& mapVotes.JCount == tableVotes.JCount ? "same" : "DIFFER")
+			<< std::endl;
+	}
+	return 0;
+}
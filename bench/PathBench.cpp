@@ -0,0 +1,152 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+
+#include "GameObject.h"
+#include "PathBatch.h"
+#include "Physics.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// Thousands of movers on paths of four to six points, with sides of uneven
+// length, half of them curved. Per tick: the old way of stepping each path
+// a parameter in control points and evaluating the curve there, against
+// PathBatch's pass over the baked tables, and PathBatch plus moving the
+// kinematic bodies as the server does. Then how much the distance moved
+// per tick varies, slowest over fastest along each path, for the median
+// path: random curves have the odd near cusp, where the baked table's
+// straight chords cut the corner, and the worst path shows only that.
+
+namespace
+{
+	const int ticks = 200;
+
+	GameObject* Mover(std::mt19937& rng, float x, float z)
+	{
+		std::uniform_real_distribution<float> length(2.f, 10.f);
+		std::uniform_int_distribution<int> corners(4, 6);
+		glm::vec3 start(x, 3.f, z);
+		GameObject *ent = new GameObject(nullptr, Shape::Box, start,
+			glm::quat(), glm::vec3(1, 0.2f, 1), glm::vec4(1), 0);
+		int n = corners(rng);
+		for (int i = 0; i < n; i++)
+		{
+			float angle = glm::two_pi<float>() * i / n;
+			float r = length(rng);
+			ent->motion.Points.push_back(start
+				+ glm::vec3(std::cos(angle), 0, std::sin(angle)) * r);
+		}
+		ent->motion.Curved = n % 2 == 0;
+		ent->motion.Speed = 0.05f;
+		ent->motion.Enabled = true;
+		ent->UpdateBody();
+		return ent;
+	}
+
+	// Path::Step as it was: a parameter counting control points
+	void ParametricStep(Path& path, float& t)
+	{
+		float end = (float)path.Points.size() - (path.Loop ? 0 : 1);
+		t += path.Speed * PLATFORM_SPEED_MODIFIER;
+		if (t > end)
+			t = path.Loop ? 0.0f : end;
+	}
+
+	// Slowest over fastest distance a tick, the median of all paths. Each
+	// step leaves where the movers are in positions.
+	template <typename F>
+	float Evenness(F step, const std::vector<glm::vec3>& positions)
+	{
+		std::vector<glm::vec3> previous;
+		std::vector<float> shortest(positions.size(), 1e30f);
+		std::vector<float> longest(positions.size(), 0.f);
+		for (int tick = 0; tick <= ticks; tick++)
+		{
+			step();
+			if (tick > 0)
+				for (std::size_t i = 0; i < positions.size(); i++)
+				{
+					float d = glm::distance(previous[i], positions[i]);
+					shortest[i] = std::min(shortest[i], d);
+					longest[i] = std::max(longest[i], d);
+				}
+			previous = positions;
+		}
+		std::vector<float> ratios(positions.size());
+		for (std::size_t i = 0; i < positions.size(); i++)
+			ratios[i] = shortest[i] / longest[i];
+		std::nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2,
+			ratios.end());
+		return ratios[ratios.size() / 2];
+	}
+}
+
+int PathBench(const std::vector<std::string>& args)
+{
+	std::cout << "us per tick, and a path's slowest / fastest tick, the"
+		" median" << std::endl;
+	std::cout << std::setw(8) << "movers" << std::setw(12) << "parametric"
+		<< std::setw(10) << "batch" << std::setw(10) << "+ bodies"
+		<< std::setw(12) << "parametric" << std::setw(10) << "batch"
+		<< std::endl;
+
+	Physics::Init();
+	for (int movers : IntArgs(args, { 1000, 4000, 16000 }))
+	{
+		std::mt19937 rng(movers);
+		std::vector<GameObject *> objects;
+		int columns = (int)std::ceil(std::sqrt((float)movers));
+		for (int i = 0; i < movers; i++)
+			objects.push_back(Mover(rng, (i % columns) * 25.f,
+				(i / columns) * 25.f));
+
+		std::vector<float> t(movers, 0.f);
+		std::vector<glm::vec3> positions(movers);
+		auto parametric = [&]()
+		{
+			for (int i = 0; i < movers; i++)
+			{
+				Path& path = objects[i]->motion;
+				ParametricStep(path, t[i]);
+				positions[i] = path.GetPosition(t[i]);
+			}
+		};
+		PathBatch batch;
+		auto batched = [&]()
+		{
+			batch.Step(objects);
+			for (int i = 0; i < movers; i++)
+				positions[i] = objects[i]->motion.GetPosition();
+		};
+
+		double parametricTime = TimeBest(parametric, ticks) * 1e6;
+		double batchTime = TimeBest(batched, ticks) * 1e6;
+		double bodiesTime = TimeBest([&]()
+		{
+			batch.Step(objects);
+			for (GameObject *ent : objects)
+				ent->Update();
+		}, ticks) * 1e6;
+
+		std::fill(t.begin(), t.end(), 0.f);
+		float parametricEvenness = Evenness(parametric, positions);
+		float batchEvenness = Evenness(batched, positions);
+		std::cout << std::setw(8) << movers << std::fixed
+			<< std::setprecision(1) << std::setw(12) << parametricTime
+			<< std::setw(10) << batchTime << std::setw(10) << bodiesTime
+			<< std::setprecision(3) << std::setw(12) << parametricEvenness
+			<< std::setw(10) << batchEvenness << std::endl;
+
+		for (GameObject *ent : objects)
+		{
+			Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
+			delete ent;
+		}
+	}
+	Physics::Cleanup();
+	return 0;
+}
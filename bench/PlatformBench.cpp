@@ -0,0 +1,172 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "GameObject.h"
+#include "Level.h"
+#include "Physics.h"
+
+#include "Bench.h"
+#include "ProfileTime.h"
+#include "config.h"
+
+// Levels of moving platforms, each on a square path, half of them curved,
+// with a box riding on it. Platforms are driven two ways: kinematic, as
+// GameObject::Update does, and as they used to be, very heavy dynamic
+// bodies pushed towards their path by inverse dynamics forces. Reported
+// are the tick, the rigid body solver's share of it, and how far the
+// platforms end a tick from where their path says they should be.
+
+namespace
+{
+	const int settleTicks = 60;
+	const int ticks = 300;
+	const float spacing = 10.f;
+	const float side = 4.f;
+	// What platforms weighed before they were kinematic
+	const float platformMass = 9999999.f;
+
+	// The old force, to reach the desired position in one step
+	glm::vec3 InverseDynamics(glm::vec3 currentPosition,
+		glm::vec3 desiredPosition, glm::vec3 currentVelocity, float mass,
+		float deltaTime)
+	{
+		glm::vec3 requiredVelocity =
+			(desiredPosition - currentPosition) / deltaTime;
+		glm::vec3 requiredAccel = (requiredVelocity - currentVelocity)
+			/ deltaTime;
+		return mass * requiredAccel;
+	}
+
+	Level* PlatformLevel(int platforms, std::vector<GameObject *>& movers)
+	{
+		Level *level = new Level(false);
+		int columns = (int)std::ceil(std::sqrt((float)platforms));
+		float extent = columns * spacing * 0.5f + spacing;
+		level->AddGameObject(glm::vec3(0, -1, 0), glm::quat(),
+			glm::vec3(extent, 1, extent), glm::vec4(1), 0, "box");
+		for (int i = 0; i < platforms; i++)
+		{
+			glm::vec3 start((i % columns) * spacing - extent + spacing, 3.f,
+				(i / columns) * spacing - extent + spacing);
+			std::size_t index = level->AddGameObject(start, glm::quat(),
+				glm::vec3(1.5f, 0.2f, 1.5f), glm::vec4(1), 0, "box");
+			GameObject *mover = level->Objects[index];
+			mover->motion.Points = { start, start + glm::vec3(side, 0, 0),
+				start + glm::vec3(side, 0, side),
+				start + glm::vec3(0, 0, side) };
+			mover->motion.Curved = i % 2 == 0;
+			mover->motion.Speed = 0.05f;
+			mover->motion.Enabled = true;
+			mover->UpdateBody();
+			movers.push_back(mover);
+			level->AddGameObject(start + glm::vec3(0, 0.65f, 0), glm::quat(),
+				glm::vec3(0.4f), glm::vec4(1), 0, "box", 1.f);
+		}
+		return level;
+	}
+
+	// Back to a dynamic body, as GameObject made it before
+	void UseInverseDynamics(GameObject *mover)
+	{
+		btRigidBody *body = mover->rigidbody;
+		Physics::dynamicsWorld->removeRigidBody(body);
+		body->setCollisionFlags(body->getCollisionFlags()
+			& ~btCollisionObject::CF_KINEMATIC_OBJECT);
+		body->setMassProps(platformMass, btVector3(0, 0, 0));
+		body->updateInertiaTensor();
+		body->setActivationState(DISABLE_DEACTIVATION);
+		Physics::dynamicsWorld->addRigidBody(body);
+	}
+
+	struct Result
+	{
+		// Milliseconds per tick, all of it and the solver's
+		double Tick = 0.0;
+		double Solver = 0.0;
+		// Distance from the path after a tick
+		double MeanError = 0.0;
+		double MaxError = 0.0;
+	};
+
+	Result Measure(int platforms, bool kinematic)
+	{
+		std::vector<GameObject *> movers;
+		Level *level = PlatformLevel(platforms, movers);
+		if (!kinematic)
+			for (GameObject *mover : movers)
+				UseInverseDynamics(mover);
+
+		Result result;
+		for (int i = 0; i < settleTicks + ticks; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			level->StepPaths();
+			for (GameObject *ent : level->Objects)
+			{
+				if (kinematic || ent->motion.Points.empty())
+				{
+					ent->Update();
+					continue;
+				}
+				// As the server ticked them before
+				btRigidBody *body = ent->rigidbody;
+				body->setAngularVelocity(btVector3(0, 0, 0));
+				body->applyCentralForce(convert(InverseDynamics(
+					ent->GetTranslation(), ent->motion.GetPosition(),
+					convert(body->getLinearVelocity()), platformMass,
+					SIMULATION_TIMESTEP)));
+			}
+			Physics::dynamicsWorld->stepSimulation(SIMULATION_TIMESTEP, 0);
+			double tick = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+			if (i < settleTicks)
+				continue;
+
+			result.Tick += tick;
+			result.Solver += ProfileTime("solveConstraints");
+			for (GameObject *mover : movers)
+			{
+				double error = mover->rigidbody->getWorldTransform()
+					.getOrigin().distance(convert(mover->motion.GetPosition()));
+				result.MeanError += error;
+				result.MaxError = std::max(result.MaxError, error);
+			}
+		}
+		result.Tick /= ticks;
+		result.Solver /= ticks;
+		result.MeanError /= (double)ticks * platforms;
+
+		for (GameObject *ent : level->Objects)
+			Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
+		delete level;
+		return result;
+	}
+
+	void Print(const Result& result)
+	{
+		std::cout << std::fixed << std::setprecision(3) << std::setw(8)
+			<< result.Tick << " /" << std::setw(6) << result.Solver
+			<< std::setprecision(4) << std::setw(8) << result.MeanError
+			<< " /" << std::setw(7) << result.MaxError;
+	}
+}
+
+int PlatformBench(const std::vector<std::string>& args)
+{
+	std::cout << "ms per tick / of it solving, and mean / max metres off"
+		" the path" << std::endl;
+	std::cout << std::setw(10) << "platforms" << std::setw(32) << "kinematic"
+		<< std::setw(32) << "inverse dynamics" << std::endl;
+
+	Physics::Init();
+	for (int platforms : IntArgs(args, { 50, 200, 1000 }))
+	{
+		std::cout << std::setw(10) << platforms;
+		Print(Measure(platforms, true));
+		Print(Measure(platforms, false));
+		std::cout << std::endl;
+	}
+	Physics::Cleanup();
+	return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <LinearMath/btVector3.h>
+
+#include "InputWindow.h"
+
+// A node's input force as Blob::AddForces computed it before
+// Blob::InputForces: eight normalised directions, each through pow. Kept
+// to check and time the kernel against.
+inline btVector3 PowInputForce(const btVector3& offset,
+	const btVector3& forward, const InputMagnitudes& inputs, float speed)
+{
+	btVector3 right = forward.cross(btVector3(0, 1, 0));
+	btVector3 fwdright = (forward + right) * SIMDSQRT12;
+	btVector3 fwdleft = (forward - right) * SIMDSQRT12;
+	btVector3 blobSpaceDir = (offset * btVector3(1, 0, 1)).normalized();
+	btScalar magnitude = btMin(
+		btPow(btMax(btDot(blobSpaceDir, forward), 0.f), 2) * inputs.Forward +
+		btPow(btMax(btDot(blobSpaceDir, -forward), 0.f), 2) * inputs.Backward +
+		btPow(btMax(btDot(blobSpaceDir, right), 0.f), 2) * inputs.Right +
+		btPow(btMax(btDot(blobSpaceDir, -right), 0.f), 2) * inputs.Left +
+		btPow(btMax(btDot(blobSpaceDir, fwdright), 0.f), 2) *
+			inputs.ForwardRight +
+		btPow(btMax(btDot(blobSpaceDir, fwdleft), 0.f), 2) *
+			inputs.ForwardLeft +
+		btPow(btMax(btDot(blobSpaceDir, -fwdleft), 0.f), 2) *
+			inputs.BackwardRight +
+		btPow(btMax(btDot(blobSpaceDir, -fwdright), 0.f), 2) *
+			inputs.BackwardLeft,
+		1.0f);
+	btVector3 force = blobSpaceDir * magnitude;
+	// Blob::AddForce dropped zero forces, and the NaN of a zero offset
+	if (force.length() > 0.0f)
+		return force * speed;
+	return btVector3(0, 0, 0);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <LinearMath/btQuickprof.h>
+
+#include <cstring>
+
+// Milliseconds in Bullet's profile samples of the given name, anywhere
+// under the iterator's parent. stepSimulation restarts the profile every
+// call, so read it after each one.
+inline float ProfileTime(CProfileIterator *it, const char *name)
+{
+	float time = 0.f;
+	int children = 0;
+	for (it->First(); !it->Is_Done(); it->Next(), children++)
+		if (strcmp(it->Get_Current_Name(), name) == 0)
+			time += it->Get_Current_Total_Time();
+	for (int i = 0; i < children; i++)
+	{
+		it->Enter_Child(i);
+		time += ProfileTime(it, name);
+		it->Enter_Parent();
+	}
+	return time;
+}
+
+// The same, for the last step as a whole
+inline float ProfileTime(const char *name)
+{
+	CProfileIterator *it = CProfileManager::Get_Iterator();
+	float time = ProfileTime(it, name);
+	CProfileManager::Release_Iterator(it);
+	return time;
+}
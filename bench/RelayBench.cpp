@@ -0,0 +1,300 @@
+#include <GLFW/glfw3.h>
+#include <RakNet/MessageIdentifiers.h>
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetStatistics.h>
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "AggregateInput.h"
+#include "InputRelay.h"
+#include "NetworkThread.h"
+#include "PacketTypes.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// Server input load over loopback with every client connected directly,
+// then with the same clients behind one relay, spread over several relays
+// side by side, and behind a chain of them. Clients send every tick, which
+// is the worst case for the send-on-change client. Relays run InputRelay,
+// as blobrelay does; the relay load is the busiest relay's.
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const char *host = "127.0.0.1";
+	const unsigned short serverPort = 61100;
+	// Relays listen on the ports after it
+	const unsigned short relayPort = 61101;
+	const int manyRelays = 4;
+	const double warmup = 2.0;
+	const double duration = 5.0;
+
+	RakNet::RakPeerInterface* StartPeer(unsigned short port, int connections)
+	{
+		RakNet::RakPeerInterface *peer =
+			RakNet::RakPeerInterface::GetInstance();
+		RakNet::SocketDescriptor sd(port, host);
+		if (peer->Startup(connections, &sd, 1) != RakNet::RAKNET_STARTED)
+		{
+			RakNet::RakPeerInterface::DestroyInstance(peer);
+			return nullptr;
+		}
+		peer->SetMaximumIncomingConnections(connections);
+		return peer;
+	}
+
+	void StopPeer(RakNet::RakPeerInterface *peer)
+	{
+		peer->Shutdown(100);
+		RakNet::RakPeerInterface::DestroyInstance(peer);
+	}
+
+	// Connects every peer, spread over the ports in turn, and waits until
+	// all are accepted, returning the remote GUID of each or an empty list
+	// on timeout
+	std::vector<RakNet::RakNetGUID> ConnectAll(
+		const std::vector<RakNet::RakPeerInterface*>& peers,
+		const std::vector<unsigned short>& ports)
+	{
+		std::vector<RakNet::RakNetGUID> remotes(peers.size(),
+			RakNet::UNASSIGNED_RAKNET_GUID);
+		for (std::size_t i = 0; i < peers.size(); i++)
+			peers[i]->Connect(host, ports[i % ports.size()], 0, 0);
+
+		std::size_t connected = 0;
+		Clock::time_point deadline = Clock::now() + std::chrono::seconds(20);
+		while (connected < peers.size() && Clock::now() < deadline)
+		{
+			for (std::size_t i = 0; i < peers.size(); i++)
+			{
+				RakNet::Packet *p;
+				while ((p = peers[i]->Receive()) != nullptr)
+				{
+					if (p->data[0] == ID_CONNECTION_REQUEST_ACCEPTED)
+					{
+						remotes[i] = p->guid;
+						connected++;
+					}
+					peers[i]->DeallocatePacket(p);
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if (connected < peers.size())
+			remotes.clear();
+		return remotes;
+	}
+
+	uint64_t BytesReceived(RakNet::RakPeerInterface *peer)
+	{
+		uint64_t bytes = 0;
+		RakNet::RakNetStatistics stats;
+		for (unsigned int i = 0; i < peer->GetMaximumNumberOfPeers(); i++)
+		{
+			RakNet::SystemAddress address = peer->GetSystemAddressFromIndex(i);
+			if (address != RakNet::UNASSIGNED_SYSTEM_ADDRESS
+				&& peer->GetStatistics(address, &stats))
+				bytes += stats.runningTotal[RakNet::ACTUAL_BYTES_RECEIVED];
+		}
+		return bytes;
+	}
+
+	struct Relay
+	{
+		RakNet::RakPeerInterface *Peer = nullptr;
+		NetworkThread *Network = nullptr;
+		RakNet::RakNetGUID Upstream = RakNet::UNASSIGNED_RAKNET_GUID;
+		InputRelay *Loop = nullptr;
+		std::thread Thread;
+	};
+
+	void StopRelays(std::vector<Relay *>& relays, std::atomic<bool>& running)
+	{
+		running = false;
+		for (Relay *relay : relays)
+		{
+			if (relay->Thread.joinable())
+				relay->Thread.join();
+			delete relay->Loop;
+			delete relay->Network;
+			StopPeer(relay->Peer);
+			delete relay;
+		}
+		relays.clear();
+	}
+
+	// Each relay connects to the server, or in a chain to the relay before
+	// it. Returns an empty list if any fails.
+	std::vector<Relay *> StartRelays(int count, bool chained, int clients,
+		std::atomic<bool>& running)
+	{
+		std::vector<Relay *> relays;
+		for (int i = 0; i < count; i++)
+		{
+			Relay *relay = new Relay;
+			relay->Peer = StartPeer(relayPort + i, clients + 2);
+			std::vector<RakNet::RakNetGUID> upstream;
+			if (relay->Peer != nullptr)
+				upstream = ConnectAll({ relay->Peer }, { (unsigned short)
+					(chained && i > 0 ? relayPort + i - 1 : serverPort) });
+			if (upstream.empty())
+			{
+				if (relay->Peer != nullptr)
+					StopPeer(relay->Peer);
+				delete relay;
+				StopRelays(relays, running);
+				return relays;
+			}
+			relay->Upstream = upstream[0];
+			relay->Network = new NetworkThread(relay->Peer);
+			relay->Network->Start();
+			relay->Loop = new InputRelay(relay->Peer, relay->Network,
+				relay->Upstream, nullptr);
+			relay->Thread = std::thread(&InputRelay::Run, relay->Loop,
+				std::cref(running), nullptr);
+			relays.push_back(relay);
+		}
+		return relays;
+	}
+
+	// With no relays every client connects directly. Otherwise clients
+	// are spread over the relays, or in a chain all join the last.
+	bool Run(int clients, int relayCount, bool chained)
+	{
+		RakNet::RakPeerInterface *server = StartPeer(serverPort, clients + 1);
+		if (server == nullptr)
+		{
+			std::cout << "Failed to listen on port " << serverPort << std::endl;
+			return false;
+		}
+		NetworkThread serverNetwork(server);
+		serverNetwork.Start();
+
+		std::atomic<bool> relaysRunning{ true };
+		std::vector<Relay *> relays = StartRelays(relayCount, chained,
+			clients, relaysRunning);
+		if ((int)relays.size() < relayCount)
+		{
+			std::cout << "Failed to start the relays" << std::endl;
+			serverNetwork.Stop();
+			StopPeer(server);
+			return false;
+		}
+		std::vector<unsigned short> ports;
+		if (relayCount == 0)
+			ports.push_back(serverPort);
+		else if (chained)
+			ports.push_back((unsigned short)(relayPort + relayCount - 1));
+		else
+			for (int i = 0; i < relayCount; i++)
+				ports.push_back((unsigned short)(relayPort + i));
+
+		std::vector<RakNet::RakPeerInterface*> peers;
+		for (int i = 0; i < clients; i++)
+			peers.push_back(StartPeer(0, 1));
+		std::vector<RakNet::RakNetGUID> remotes = ConnectAll(peers, ports);
+		bool ok = !remotes.empty();
+		// The server's tick, at the same rate as the clients send
+		std::vector<NetMessage> messages;
+		AggregateInput inputs;
+		uint64_t packets = 0, bytes = 0, votes = 0, ticks = 0;
+		auto interval = std::chrono::microseconds(1000000 / RELAY_TICK_RATE);
+		Clock::time_point start = Clock::now();
+		Clock::time_point measure = start
+			+ std::chrono::microseconds((int64_t)(warmup * 1e6));
+		Clock::time_point end = measure
+			+ std::chrono::microseconds((int64_t)(duration * 1e6));
+		Clock::time_point next_tick = start;
+		bool measuring = false;
+		for (uint32_t tick = 0; ok && Clock::now() < end; tick++)
+		{
+			for (int i = 0; i < clients; i++)
+			{
+				RakNet::Packet *p;
+				while ((p = peers[i]->Receive()) != nullptr)
+					peers[i]->DeallocatePacket(p);
+				unsigned char data[2] = { ID_BLOB_INPUT,
+					(unsigned char)((tick + i) % (Jump + 1)) };
+				peers[i]->Send((const char *)data, 2, HIGH_PRIORITY,
+					UNRELIABLE_SEQUENCED, INPUT_CHANNEL, remotes[i], false);
+			}
+
+			serverNetwork.SwapMessages(messages);
+			if (serverNetwork.SwapInputs(inputs) && measuring)
+			{
+				votes += inputs.TotalCount;
+				ticks++;
+			}
+			if (!measuring && Clock::now() >= measure)
+			{
+				measuring = true;
+				packets = serverNetwork.InputPackets;
+				bytes = BytesReceived(server);
+			}
+
+			next_tick += interval;
+			std::this_thread::sleep_until(next_tick);
+		}
+
+		if (ok)
+		{
+			packets = serverNetwork.InputPackets - packets;
+			bytes = BytesReceived(server) - bytes;
+			float relayLoad = 0.f;
+			for (Relay *relay : relays)
+				relayLoad = std::max(relayLoad, (float)relay->Network->Load);
+			std::string path = relayCount == 0 ? "direct" :
+				relayCount == 1 ? "relay" : std::to_string(relayCount)
+				+ (chained ? " chained" : " relays");
+			std::cout << std::setw(8) << clients << std::setw(11) << path
+				<< std::setw(14) << (uint64_t)(packets / duration)
+				<< std::setw(14) << (uint64_t)(bytes / duration)
+				<< std::setw(12) << std::fixed << std::setprecision(3)
+				<< (float)serverNetwork.Load
+				<< std::setw(12) << std::setprecision(1)
+				<< (ticks ? (double)votes / ticks : 0.0)
+				<< std::setw(12) << std::setprecision(3)
+				<< relayLoad << std::endl;
+		}
+		else
+			std::cout << "Timed out connecting " << clients << " clients"
+				<< std::endl;
+
+		for (RakNet::RakPeerInterface *peer : peers)
+			StopPeer(peer);
+		StopRelays(relays, relaysRunning);
+		serverNetwork.Stop();
+		StopPeer(server);
+		return ok;
+	}
+}
+
+int RelayBench(const std::vector<std::string>& args)
+{
+	// Only used for its timer, which the network thread stamps inputs with
+	glfwInit();
+
+	std::cout << std::setw(8) << "clients" << std::setw(11) << "path"
+		<< std::setw(14) << "inputs/s" << std::setw(14) << "bytes/s"
+		<< std::setw(12) << "net load" << std::setw(12) << "votes/tick"
+		<< std::setw(12) << "relay load" << std::endl;
+	for (int clients : IntArgs(args, { 50, 200, 500 }))
+	{
+		Run(clients, 0, false);
+		Run(clients, 1, false);
+		Run(clients, manyRelays, false);
+		Run(clients, manyRelays, true);
+	}
+
+	glfwTerminate();
+	return 0;
+}
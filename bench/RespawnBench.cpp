@@ -0,0 +1,84 @@
+#include <iostream>
+#include <iomanip>
+
+#include "Blob.h"
+#include "Physics.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// Respawning a blob that has been rolling about, the old way and the new:
+// Physics::CreateBlob's delete and rebuild, against Blob::Reset. Blobs are
+// built without meshes, so the rebuild's GL buffers aren't counted and it
+// costs at least this much more. The first tick after each is timed too,
+// as a new body also has its links coloured again by the solver.
+
+namespace
+{
+	const int settleTicks = 120;
+	const int runs = 5;
+	const btVector3 spawn(0, 15, 0);
+	const btScalar radius = 3.0f;
+
+	Blob* NewBlob(int nodes)
+	{
+		Blob *blob = new Blob(Physics::softBodyWorldInfo, spawn, radius,
+			nodes, BLOB_RENDER_SUBDIVISIONS, false);
+		Physics::dynamicsWorld->addSoftBody(blob->softbody);
+		return blob;
+	}
+
+	void Step(int ticks)
+	{
+		for (int i = 0; i < ticks; i++)
+			Physics::dynamicsWorld->stepSimulation(SIMULATION_TIMESTEP, 0);
+	}
+
+	// Milliseconds to respawn, and for the tick after
+	void Measure(int nodes, bool reset, double& respawn, double& tick)
+	{
+		Blob *blob = NewBlob(nodes);
+		respawn = tick = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			Step(settleTicks);
+			respawn = std::min(respawn, TimeBest([&]()
+			{
+				if (reset)
+				{
+					blob->Reset();
+					return;
+				}
+				// As Physics::CreateBlob does it
+				Physics::dynamicsWorld->removeSoftBody(blob->softbody);
+				delete blob;
+				blob = NewBlob(nodes);
+			}, 1, 1) * 1e3);
+			tick = std::min(tick, TimeBest([]() { Step(1); }, 1, 1) * 1e3);
+		}
+		Physics::dynamicsWorld->removeSoftBody(blob->softbody);
+		delete blob;
+	}
+}
+
+int RespawnBench(const std::vector<std::string>& args)
+{
+	std::cout << "ms to respawn / ms for the tick after" << std::endl;
+	std::cout << std::setw(8) << "nodes" << std::setw(20) << "create"
+		<< std::setw(20) << "reset" << std::endl;
+
+	// No level, so the blob just falls; a floor wouldn't change a respawn
+	Physics::Init();
+	for (int nodes : IntArgs(args, { 256, BLOB_NODES, 1024 }))
+	{
+		double create, createTick, reset, resetTick;
+		Measure(nodes, false, create, createTick);
+		Measure(nodes, true, reset, resetTick);
+		std::cout << std::setw(8) << nodes << std::fixed
+			<< std::setprecision(3) << std::setw(11) << create << " /"
+			<< std::setw(7) << createTick << std::setw(11) << reset << " /"
+			<< std::setw(7) << resetTick << std::endl;
+	}
+	Physics::Cleanup();
+	return 0;
+}
@@ -0,0 +1,113 @@
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+
+#include "ParallelSoftBodySolver.h"
+#include "SoftWorld.h"
+
+#include "Bench.h"
+#include "config.h"
+
+// Whole soft body solve per tick, Bullet's serial solver against the
+// coloured one at each thread count, for a blob resting on the floor.
+// SOFTBODY_PARALLEL_MIN_LINKS should sit where the threaded columns start
+// beating the one thread column. With fewer cores than threads they never
+// will; weigh the one thread column against colours + 2 dispatches instead.
+
+namespace
+{
+	const int settleTicks = 60;
+	const int measureTicks = 200;
+
+	class TimedSolver : public btDefaultSoftBodySolver
+	{
+		public:
+			double Time = 0.0;
+
+			virtual void solveConstraints(float solverdt)
+			{
+				auto start = std::chrono::steady_clock::now();
+				btDefaultSoftBodySolver::solveConstraints(solverdt);
+				Time += std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - start).count();
+			}
+	};
+
+	double BulletSolve(int& nodes, int& links)
+	{
+		TimedSolver solver;
+		SoftWorld world(&solver, nodes);
+		nodes = world.Body->m_nodes.size();
+		links = world.Body->m_links.size();
+		world.Step(settleTicks);
+		solver.Time = 0.0;
+		world.Step(measureTicks);
+		return solver.Time / measureTicks;
+	}
+
+	double ColouredSolve(int nodes, int threads, int minLinks,
+		int *colours = nullptr)
+	{
+		ParallelSoftBodySolver solver(threads, minLinks);
+		SoftWorld world(&solver, nodes);
+		world.Step(settleTicks);
+		if (colours)
+			*colours = solver.Colours;
+		double time = 0.0;
+		for (int i = 0; i < measureTicks; i++)
+		{
+			world.Step(1);
+			time += solver.SolveTime;
+		}
+		return time / measureTicks;
+	}
+}
+
+int SoftBodyBench(const std::vector<std::string>& args)
+{
+	const int threadCounts[] = { 1, 2, 4, 8 };
+
+	// Each colour is one dispatch to the pool, plus two loops over all
+	// links and nodes, so this is what a parallel solve pays per colour
+	std::cout << "us per pool dispatch, "
+		<< std::thread::hardware_concurrency() << " hardware threads:";
+	for (int threads : threadCounts)
+	{
+		WorkerPool pool(threads);
+		double dispatch = TimeBest([&]()
+		{
+			pool.Run(threads, [](int, int) {});
+		}, 1000);
+		std::cout << " " << threads << "t " << std::fixed
+			<< std::setprecision(2) << dispatch * 1e6;
+	}
+	std::cout << std::endl << std::endl;
+
+	std::cout << "ms per solve" << std::endl;
+	std::cout << std::setw(8) << "nodes" << std::setw(8) << "links"
+		<< std::setw(8) << "colours" << std::setw(10) << "bullet";
+	for (int threads : threadCounts)
+		std::cout << std::setw(9) << threads << "t";
+	std::cout << std::setw(10) << "default" << std::endl;
+
+	for (int target : IntArgs(args, { 512, 1024, 2048, 4096, 8192 }))
+	{
+		int nodes = target, links, colours;
+		double bullet = BulletSolve(nodes, links);
+		double serial = ColouredSolve(target, 1, 0, &colours);
+		std::cout << std::setw(8) << nodes << std::setw(8) << links
+			<< std::setw(8) << colours << std::setw(10) << std::fixed
+			<< std::setprecision(3) << bullet << std::setw(10) << serial;
+		for (int threads : threadCounts)
+			if (threads > 1)
+				std::cout << std::setw(10) << ColouredSolve(target, threads, 0);
+		// As the server runs it
+		std::cout << std::setw(10) << ColouredSolve(target,
+			SOFTBODY_SOLVER_THREADS, SOFTBODY_PARALLEL_MIN_LINKS)
+			<< std::endl;
+	}
+	return 0;
+}
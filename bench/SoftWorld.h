@@ -0,0 +1,82 @@
+#pragma once
+
+#include <btBulletDynamicsCommon.h>
+#include <BulletSoftBody/btSoftRigidDynamicsWorld.h>
+#include <BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h>
+#include <BulletSoftBody/btSoftBodyHelpers.h>
+
+#include "Blob.h"
+#include "config.h"
+
+// A blob dropped on a floor in a world of its own, set up like Physics
+// but with the soft body solver passed in and nothing to draw
+struct SoftWorld
+{
+	btSoftBodyRigidBodyCollisionConfiguration Config;
+	btCollisionDispatcher Dispatcher{ &Config };
+	btDbvtBroadphase Broadphase;
+	btSequentialImpulseConstraintSolver Solver;
+	btSoftBodyWorldInfo Info;
+	btSoftRigidDynamicsWorld *World;
+	btBoxShape FloorShape{ btVector3(50, 1, 50) };
+	btRigidBody *Floor;
+	btSoftBody *Body;
+	const btVector3 Center{ 0, 5, 0 };
+	const btScalar Radius = 3.0f;
+
+	// Roughly the given number of nodes. Bullet's hull tops out around a
+	// thousand nodes, so bigger blobs are subdivided, each level roughly
+	// quadrupling the count
+	SoftWorld(btSoftBodySolver *softSolver, int nodes) :
+		SoftWorld(softSolver, HullNodes(nodes), Subdivisions(nodes))
+	{ }
+
+	// A blob of the given hull nodes, simulated subdivided
+	SoftWorld(btSoftBodySolver *softSolver, int nodes, int subdivisions)
+	{
+		World = new btSoftRigidDynamicsWorld(&Dispatcher, &Broadphase,
+			&Solver, &Config, softSolver);
+		World->setGravity(btVector3(0, -10, 0));
+		Info.m_broadphase = &Broadphase;
+		Info.m_dispatcher = &Dispatcher;
+		Info.m_gravity.setValue(0, -10, 0);
+		Info.air_density = (btScalar)0.2;
+		Info.m_sparsesdf.Initialize();
+
+		Floor = new btRigidBody(0, nullptr, &FloorShape);
+		World->addRigidBody(Floor);
+		Body = Blob::CreateSoftBody(Info, Center, Radius, nodes,
+			subdivisions);
+		// Measure it solving, not asleep on the floor
+		Body->setActivationState(DISABLE_DEACTIVATION);
+		World->addSoftBody(Body);
+	}
+
+	~SoftWorld()
+	{
+		World->removeSoftBody(Body);
+		World->removeRigidBody(Floor);
+		delete Body;
+		delete Floor;
+		delete World;
+	}
+
+	void Step(int ticks)
+	{
+		for (int i = 0; i < ticks; i++)
+			World->stepSimulation(SIMULATION_TIMESTEP, 0);
+	}
+
+	static int Subdivisions(int nodes)
+	{
+		int subdivisions = 0;
+		for (; nodes > 1024; nodes /= 4)
+			subdivisions++;
+		return subdivisions;
+	}
+
+	static int HullNodes(int nodes)
+	{
+		return nodes >> (2 * Subdivisions(nodes));
+	}
+};
@@ -0,0 +1,295 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "Bench.h"
+
+#ifdef __linux__
+
+#include <GLFW/glfw3.h>
+#include <RakNet/MessageIdentifiers.h>
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetStatistics.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include "NetworkThread.h"
+#include "PacketTypes.h"
+#include "UdpInputEndpoint.h"
+#include "config.h"
+
+// Input packets per second each input path takes in on loopback, with
+// every sender flooding as fast as it can: datagrams at UdpInputEndpoint,
+// and RakNet input messages at a peer read by NetworkThread. Both feed the
+// same input queue; accepted inputs are the ones that reached it, dropped
+// the ones it had no room for. What the socket or RakNet lost on the way
+// is the difference from sent.
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	const char *host = "127.0.0.1";
+	const unsigned short rakNetPort = 61110;
+	const unsigned short udpPort = rakNetPort + UDP_INPUT_PORT_OFFSET;
+	const double warmup = 1.0;
+	const double duration = 3.0;
+	// RakNet messages a sender may have waiting before it backs off, so
+	// its send buffer doesn't grow without bound
+	const unsigned int rakNetBacklog = 4096;
+
+	struct Counts
+	{
+		uint64_t Sent;
+		uint64_t Accepted;
+		uint64_t Dropped;
+	};
+
+	void FloodUdp(uint64_t token, const std::atomic<bool> *running,
+		std::atomic<uint64_t> *sent)
+	{
+		int fd = socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = htons(udpPort);
+		if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) < 0)
+		{
+			if (fd >= 0)
+				close(fd);
+			return;
+		}
+
+		UdpInputPacket packets[UDP_INPUT_BATCH];
+		iovec iovecs[UDP_INPUT_BATCH];
+		mmsghdr messages[UDP_INPUT_BATCH] = {};
+		for (int i = 0; i < UDP_INPUT_BATCH; i++)
+		{
+			iovecs[i].iov_base = &packets[i];
+			iovecs[i].iov_len = sizeof(UdpInputPacket);
+			messages[i].msg_hdr.msg_iov = &iovecs[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		uint16_t sequence = 0;
+		while (*running)
+		{
+			for (int i = 0; i < UDP_INPUT_BATCH; i++)
+				packets[i] = { token, ++sequence,
+					(uint8_t)(sequence % (Jump + 1)) };
+			int count = sendmmsg(fd, messages, UDP_INPUT_BATCH, 0);
+			if (count > 0)
+				*sent += count;
+		}
+		close(fd);
+	}
+
+	void FloodRakNet(RakNet::RakPeerInterface *peer,
+		RakNet::RakNetGUID server, const std::atomic<bool> *running,
+		std::atomic<uint64_t> *sent)
+	{
+		RakNet::SystemAddress address = peer->GetSystemAddressFromGuid(server);
+		RakNet::RakNetStatistics stats;
+		for (uint32_t i = 0; *running; i++)
+		{
+			RakNet::Packet *p;
+			while ((p = peer->Receive()) != nullptr)
+				peer->DeallocatePacket(p);
+			if (peer->GetStatistics(address, &stats)
+				&& stats.messageInSendBuffer[HIGH_PRIORITY] > rakNetBacklog)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			unsigned char data[2] = { ID_BLOB_INPUT,
+				(unsigned char)(i % (Jump + 1)) };
+			peer->Send((const char *)data, 2, HIGH_PRIORITY,
+				UNRELIABLE_SEQUENCED, INPUT_CHANNEL, server, false);
+			(*sent)++;
+		}
+	}
+
+	RakNet::RakPeerInterface* StartPeer(unsigned short port, int connections)
+	{
+		RakNet::RakPeerInterface *peer =
+			RakNet::RakPeerInterface::GetInstance();
+		RakNet::SocketDescriptor sd(port, host);
+		if (peer->Startup(connections, &sd, 1) != RakNet::RAKNET_STARTED)
+		{
+			RakNet::RakPeerInterface::DestroyInstance(peer);
+			return nullptr;
+		}
+		peer->SetMaximumIncomingConnections(connections);
+		return peer;
+	}
+
+	void StopPeer(RakNet::RakPeerInterface *peer)
+	{
+		peer->Shutdown(100);
+		RakNet::RakPeerInterface::DestroyInstance(peer);
+	}
+
+	// Connects a client to the server and returns the server's GUID, or
+	// unassigned on timeout
+	RakNet::RakNetGUID Connect(RakNet::RakPeerInterface *peer)
+	{
+		peer->Connect(host, rakNetPort, 0, 0);
+		Clock::time_point deadline = Clock::now() + std::chrono::seconds(10);
+		while (Clock::now() < deadline)
+		{
+			RakNet::Packet *p;
+			while ((p = peer->Receive()) != nullptr)
+			{
+				bool accepted = p->data[0] == ID_CONNECTION_REQUEST_ACCEPTED;
+				RakNet::RakNetGUID guid = p->guid;
+				peer->DeallocatePacket(p);
+				if (accepted)
+					return guid;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return RakNet::UNASSIGNED_RAKNET_GUID;
+	}
+
+	// Counts over the measured seconds, after a warmup. Both paths count
+	// an input before pushing it onto the queue.
+	template <typename F>
+	Counts Measure(const std::atomic<uint64_t>& sent, F accepted,
+		NetworkThread& network)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(
+			(int64_t)(warmup * 1e6)));
+		Counts start = { sent, accepted(), network.DroppedInputs };
+		std::this_thread::sleep_for(std::chrono::microseconds(
+			(int64_t)(duration * 1e6)));
+		Counts end = { sent, accepted(), network.DroppedInputs };
+		uint64_t dropped = end.Dropped - start.Dropped;
+		return { end.Sent - start.Sent,
+			end.Accepted - start.Accepted - dropped, dropped };
+	}
+
+	bool RunUdp(int senders, NetworkThread& network, Counts& counts)
+	{
+		UdpInputEndpoint endpoint(&network);
+		if (!endpoint.Start(udpPort))
+			return false;
+
+		std::atomic<bool> running{ true };
+		std::atomic<uint64_t> sent{ 0 };
+		std::vector<std::thread> threads;
+		for (int i = 0; i < senders; i++)
+		{
+			uint64_t token = endpoint.AddSession(RakNet::RakNetGUID(i + 1));
+			threads.emplace_back(FloodUdp, token, &running, &sent);
+		}
+		counts = Measure(sent, [&]() { return endpoint.Received.load(); },
+			network);
+		running = false;
+		for (std::thread& thread : threads)
+			thread.join();
+		endpoint.Stop();
+		return true;
+	}
+
+	bool RunRakNet(int senders, NetworkThread& network, Counts& counts)
+	{
+		std::vector<RakNet::RakPeerInterface*> peers;
+		std::vector<RakNet::RakNetGUID> servers;
+		bool ok = true;
+		for (int i = 0; i < senders && ok; i++)
+		{
+			RakNet::RakPeerInterface *peer = StartPeer(0, 1);
+			if (peer == nullptr)
+			{
+				ok = false;
+				break;
+			}
+			peers.push_back(peer);
+			servers.push_back(Connect(peer));
+			ok = servers.back() != RakNet::UNASSIGNED_RAKNET_GUID;
+		}
+
+		if (ok)
+		{
+			std::atomic<bool> running{ true };
+			std::atomic<uint64_t> sent{ 0 };
+			std::vector<std::thread> threads;
+			for (int i = 0; i < senders; i++)
+				threads.emplace_back(FloodRakNet, peers[i], servers[i],
+					&running, &sent);
+			counts = Measure(sent, [&]()
+			{
+				return network.InputPackets.load();
+			}, network);
+			running = false;
+			for (std::thread& thread : threads)
+				thread.join();
+		}
+		for (RakNet::RakPeerInterface *peer : peers)
+			StopPeer(peer);
+		return ok;
+	}
+
+	void Print(const Counts& counts)
+	{
+		std::cout << std::setw(12) << (uint64_t)(counts.Sent / duration)
+			<< std::setw(12) << (uint64_t)(counts.Accepted / duration)
+			<< std::setw(10) << (uint64_t)(counts.Dropped / duration);
+	}
+}
+
+int UdpInputBench(const std::vector<std::string>& args)
+{
+	// Only used for its timer, which the network thread stamps inputs with
+	glfwInit();
+
+	std::cout << "input packets per second: sent / accepted / dropped"
+		<< std::endl;
+	std::cout << std::setw(8) << "senders" << std::setw(34) << "datagrams"
+		<< std::setw(34) << "raknet" << std::endl;
+	for (int senders : IntArgs(args, { 1, 4, 16 }))
+	{
+		RakNet::RakPeerInterface *server = StartPeer(rakNetPort, senders);
+		if (server == nullptr)
+		{
+			std::cout << "Failed to listen on port " << rakNetPort
+				<< std::endl;
+			break;
+		}
+		NetworkThread network(server);
+		network.Start();
+
+		std::cout << std::setw(8) << senders;
+		Counts counts;
+		if (RunUdp(senders, network, counts))
+			Print(counts);
+		else
+			std::cout << std::setw(34) << "failed to bind";
+		if (RunRakNet(senders, network, counts))
+			Print(counts);
+		else
+			std::cout << std::setw(34) << "failed to connect";
+		std::cout << std::endl;
+
+		network.Stop();
+		StopPeer(server);
+	}
+
+	glfwTerminate();
+	return 0;
+}
+
+#else
+
+int UdpInputBench(const std::vector<std::string>& args)
+{
+	std::cout << "Datagram input is Linux only" << std::endl;
+	return 1;
+}
+
+#endif // __linux__
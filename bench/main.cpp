@@ -0,0 +1,52 @@
+#include <iostream>
+#include <cstring>
+
+#include "Bench.h"
+
+// Microbenchmarks and scenario benchmarks behind one executable:
+//   blobbench <name> [args]
+// Run with no name to list them.
+
+int RelayBench(const std::vector<std::string>& args);
+int UdpInputBench(const std::vector<std::string>& args);
+int InputTableBench(const std::vector<std::string>& args);
+int SoftBodyBench(const std::vector<std::string>& args);
+int InputForcesBench(const std::vector<std::string>& args);
+int EmbeddingBench(const std::vector<std::string>& args);
+int BroadphaseBench(const std::vector<std::string>& args);
+int BakeBench(const std::vector<std::string>& args);
+int RespawnBench(const std::vector<std::string>& args);
+int PlatformBench(const std::vector<std::string>& args);
+int PathBench(const std::vector<std::string>& args);
+
+const Bench benches[] = {
+	{ "relay", "[clients...]", RelayBench },
+	{ "udpinput", "[senders...]", UdpInputBench },
+	{ "inputtable", "[players...]", InputTableBench },
+	{ "softbody", "[nodes...]", SoftBodyBench },
+	{ "inputforces", "[nodes...]", InputForcesBench },
+	{ "embedding", "[coarse nodes...]", EmbeddingBench },
+	{ "broadphase", "[level files or box counts...]", BroadphaseBench },
+	{ "bake", "[level files or static counts...]", BakeBench },
+	{ "respawn", "[nodes...]", RespawnBench },
+	{ "platforms", "[platforms...]", PlatformBench },
+	{ "paths", "[movers...]", PathBench },
+};
+
+int main(int argc, char *argv[])
+{
+	if (argc >= 2)
+	{
+		for (const Bench& bench : benches)
+		{
+			if (strcmp(argv[1], bench.Name) != 0)
+				continue;
+			return bench.Run(std::vector<std::string>(argv + 2, argv + argc));
+		}
+	}
+
+	std::cout << "Usage: blobbench <name> [args]" << std::endl;
+	for (const Bench& bench : benches)
+		std::cout << "  " << bench.Name << " " << bench.Usage << std::endl;
+	return 1;
+}
@@ -8,6 +8,7 @@
 
 #include <memory>
 #include <thread>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <codecvt>
@@ -17,15 +18,38 @@
 #include "Buffer.h"
 #include "Text.h"
 #include "BlobInput.h"
+#include "PacketTypes.h"
 #include "HostData.h"
+#include "Discovery.h"
 #include "StreamReceiver.h"
+#include "IOBuffer.h"
+#include "StateSync.h"
+#include "RenderingManager.h"
+#include "Physics.h"
 
 #include "config.h"
 
+#ifdef __linux__
+#include "UdpInputEndpoint.h"
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif // __linux__
+
 bool connect();
+void discover();
+void join();
+void leave();
 bool init();
+bool init_state();
+bool load_level(const std::string& name);
+bool match_level(const SyncState& s);
+void receive();
 void update();
 void draw();
+bool draw_stream();
+void send_input();
+void draw_state();
 std::string convert(std::u32string str);
 void key_callback(
 		GLFWwindow *window, int key, int scancode, int action, int mods);
@@ -39,6 +63,8 @@ std::unique_ptr<Text> spectator_indicator;
 std::shared_ptr<Font> med_font;
 std::shared_ptr<Font> lg_font;
 std::unique_ptr<ShaderProgram> stream_program;
+std::unique_ptr<ShaderProgram> upscale_program;
+IOBuffer upscale_buffer;
 std::unique_ptr<ShaderProgram> text_program;
 int width, height;
 std::string stream_address;
@@ -54,9 +80,30 @@ std::u32string input_text;
 RakNet::RakPeerInterface *rakPeer = RakNet::RakPeerInterface::GetInstance();
 RakNet::SystemAddress hostAddress = RakNet::UNASSIGNED_SYSTEM_ADDRESS;
 BlobInput current_input;
+BlobInput sent_input = NoInput;
+double last_input_time = 0.0;
+double last_input_send = 0.0;
+#ifdef __linux__
+// Inputs go over plain datagrams once the server offers a session
+int input_socket = -1;
+uint64_t input_token;
+uint16_t input_sequence = 0;
+#endif // __linux__
+
+// Render the simulation locally from state updates instead of video
+bool state_mode = false;
+SyncState state;
+// Layout of the level loaded, and the last level the server was found to
+// run that didn't match it
+uint32_t level_layout = 0;
+std::string mismatched_level;
+RenderingManager renderManager;
+std::unique_ptr<BlobCam> blobCam;
+Level* Level::currentLevel;
 
 int main(int argc, char *argv[])
 {
+	state_mode = argc > 1 && std::string(argv[1]) == "--state";
 	if (!connect())
 		return 1;
 	window = GLFWProject::Init("Blobclient", CLIENT_WIDTH, CLIENT_HEIGHT);
@@ -80,6 +127,8 @@ int main(int argc, char *argv[])
 	rakPeer->Shutdown(100);
 	RakNet::RakPeerInterface::DestroyInstance(rakPeer);
 
+	if (state_mode)
+		Physics::Cleanup();
 	glfwTerminate();
 	return 0;
 }
@@ -92,39 +141,56 @@ bool connect()
 		return false;
 
 	while (hostAddress == RakNet::UNASSIGNED_SYSTEM_ADDRESS)
-	{
-		bool connected = false;
-		while (rakPeer->GetReceiveBufferSize() > 0)
-		{
-			RakNet::Packet *p = rakPeer->Receive();
-			unsigned char packet_type = p->data[0];
-			RakNet::SystemAddress sender = p->systemAddress;
-			rakPeer->DeallocatePacket(p);
-			if (packet_type == ID_UNCONNECTED_PONG)
-			{
-				hostAddress = sender;
-				const char *host = sender.ToString();
-				rakPeer->Connect(host, REMOTE_GAME_PORT, NULL, 0);
-				connected = true;
+		discover();
+
+	return true;
+}
+
+// Joins a server that answers discovery with room left, more likely the
+// less loaded it is
+void discover()
+{
+	DiscoveredHost found;
+	if (!Discover(rakPeer, "255.255.255.255", REMOTE_GAME_PORT, found))
+		return;
+
+	hostAddress = found.Address;
+	// Video spectators only need the stream endpoint
+	if (state_mode || !spectator_mode)
+		join();
 #ifdef RTMP_STREAM
-				std::ostringstream ss;
-				ss << STREAM_PROTOCOL << sender.ToString(false)
-					<< RTMP_PATH;
-				stream_address = ss.str();
+	std::ostringstream ss;
+	ss << STREAM_PROTOCOL << found.Address.ToString(false) << RTMP_PATH;
+	stream_address = ss.str();
 #else // RTMP_STREAM
-				stream_address = STREAM_PATH "?fifo_size=520192&overrun_nonfatal=1";
+	found.Data.StreamEndpoint[sizeof(found.Data.StreamEndpoint) - 1] = '\0';
+	stream_address = found.Data.StreamEndpoint[0] ?
+		found.Data.StreamEndpoint : STREAM_PATH;
+	stream_address += "?fifo_size=520192&overrun_nonfatal=1";
 #endif // RTMP_STREAM
-				break;
-			}
-		}
-		if (!connected)
-		{
-			rakPeer->Ping("255.255.255.255", REMOTE_GAME_PORT, true);
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-		}
-	}
+	std::cout << "Watching " << found.Address.ToString() << " with "
+		<< found.Data.Players << " players" << std::endl;
+}
 
-	return true;
+void join()
+{
+	RakNet::ConnectionState connection =
+		rakPeer->GetConnectionState(hostAddress);
+	if (connection == RakNet::IS_NOT_CONNECTED
+		|| connection == RakNet::IS_DISCONNECTED
+		|| connection == RakNet::IS_SILENTLY_DISCONNECTING)
+		rakPeer->Connect(hostAddress.ToString(false), hostAddress.GetPort(),
+			NULL, 0);
+}
+
+void leave()
+{
+	rakPeer->CloseConnection(hostAddress, true);
+#ifdef __linux__
+	if (input_socket >= 0)
+		close(input_socket);
+	input_socket = -1;
+#endif // __linux__
 }
 
 bool init()
@@ -137,6 +203,16 @@ bool init()
 	vbo->VertexAttribPointer(0);
 
 	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(
+			GL_TEXTURE_2D, 0, GL_RGBA,
+			STREAM_WIDTH, STREAM_HEIGHT, 0,
+			GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	if (!upscale_buffer.Init(width, height, false, GL_RGB16F))
+		return false;
 	med_font = std::shared_ptr<Font>(new Font(FontDir "ClearSans-Regular.ttf", 20.f));
 	lg_font = std::shared_ptr<Font>(new Font(FontDir "ClearSans-Regular.ttf", 36.f));
 	input_display = std::unique_ptr<Text>(new Text(med_font.get()));
@@ -148,6 +224,10 @@ bool init()
 	spectator_indicator->YPosition = height - 64;
 	spectator_indicator->SetText("PRESS SPACE TO BLOB");
 
+	upscale_program = std::unique_ptr<ShaderProgram>(new ShaderProgram({
+			ShaderDir "Stream.vert",
+			ShaderDir "Upscale.frag" }));
+
 	stream_program = std::unique_ptr<ShaderProgram>(new ShaderProgram({
 			ShaderDir "Stream.vert",
 			ShaderDir "Stream.frag" }));
@@ -156,11 +236,22 @@ bool init()
 			ShaderDir "Text.vert",
 			ShaderDir "Text.frag" }));
 
-	stream = std::unique_ptr<StreamReceiver>(
-			new StreamReceiver(stream_address.c_str(), width, height));
-	data = (uint8_t *)malloc(width * height * 4);
+	if (state_mode)
+	{
+		if (!init_state())
+			return false;
+	}
+	else
+	{
+		// Frames stay at stream resolution and are upscaled on the GPU
+		stream = std::unique_ptr<StreamReceiver>(new StreamReceiver(
+				stream_address.c_str(), STREAM_WIDTH, STREAM_HEIGHT));
+	}
+	data = (uint8_t *)malloc(STREAM_WIDTH * STREAM_HEIGHT * 4);
 
+	(*upscale_program)["uImage"] = 0;
 	(*stream_program)["uImage"] = 0;
+	(*stream_program)["uSharpness"] = CLIENT_SHARPNESS;
 
 	glm::mat4 projMatrix = glm::ortho(0.f, (float)width, 0.f, (float)height);
 	(*text_program)["uAtlas"] = 0;
@@ -170,60 +261,149 @@ bool init()
 	return true;
 }
 
-void update()
+bool init_state()
 {
-	input_display->SetText(convert(input_text) + '_');
+	Physics::Init();
+	Physics::CreateBlob();
+	// Until the first keyframe says which level the server runs
+	Level::currentLevel = Level::Deserialize(LevelDir "level1.json");
+	if (!Level::currentLevel || !renderManager.init())
+		return false;
+	level_layout = Level::currentLevel->Layout();
+	blobCam = std::unique_ptr<BlobCam>(new BlobCam());
+	return true;
 }
 
-void draw()
+bool load_level(const std::string& name)
+{
+	// Names come from the server, so only ones in LevelDir
+	if (name.empty() || name.find_first_of("/\\") != std::string::npos
+		|| name.find("..") != std::string::npos)
+		return false;
+	Level *level = Level::Deserialize(LevelDir + name);
+	if (!level)
+		return false;
+	for (GameObject *ent : Level::currentLevel->Objects)
+		Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
+	delete Level::currentLevel;
+	Level::currentLevel = level;
+	level_layout = level->Layout();
+	return true;
+}
+
+// State sync addresses objects by index, so it only applies to a copy of
+// the level the server runs. Another level is loaded if the client has it.
+bool match_level(const SyncState& s)
 {
-	if (hostAddress == RakNet::UNASSIGNED_SYSTEM_ADDRESS)
+	if (s.LevelLayout == level_layout)
+		return true;
+	// Tried once per mismatch, rather than on every packet
+	if (s.LevelName == mismatched_level)
+		return false;
+	mismatched_level = s.LevelName;
+	if (load_level(s.LevelName) && s.LevelLayout == level_layout)
+		return true;
+	std::cout << "The server's level " << s.LevelName << " differs from "
+		"this client's, so its state isn't shown" << std::endl;
+	return false;
+}
+
+void receive()
+{
+	while (rakPeer->GetReceiveBufferSize() > 0)
 	{
-		bool connected = false;
-		while (rakPeer->GetReceiveBufferSize() > 0)
+		RakNet::Packet *p = rakPeer->Receive();
+		unsigned char packet_type = p->data[0];
+		if (packet_type == ID_CONNECTION_REQUEST_ACCEPTED && state_mode)
+		{
+			char subscribe = ID_BLOB_STATE_SUBSCRIBE;
+			rakPeer->Send(&subscribe, 1, HIGH_PRIORITY, RELIABLE_ORDERED,
+				STATE_SYNC_CHANNEL, hostAddress, false);
+		}
+#ifdef __linux__
+		else if (packet_type == ID_BLOB_INPUT_SESSION && p->length >= 11
+			&& input_socket < 0)
 		{
-			RakNet::Packet *p = rakPeer->Receive();
-			unsigned char packet_type = p->data[0];
-			RakNet::SystemAddress sender = p->systemAddress;
-			rakPeer->DeallocatePacket(p);
-			if (packet_type == ID_UNCONNECTED_PONG)
+			uint16_t port;
+			memcpy(&input_token, p->data + 1, 8);
+			memcpy(&port, p->data + 9, 2);
+			sockaddr_in address = {};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			inet_pton(AF_INET, hostAddress.ToString(false), &address.sin_addr);
+			input_socket = socket(AF_INET, SOCK_DGRAM, 0);
+			if (input_socket >= 0 && connect(input_socket,
+					(sockaddr *)&address, sizeof(address)) < 0)
+			{
+				close(input_socket);
+				input_socket = -1;
+			}
+		}
+#endif // __linux__
+		else if (packet_type == ID_BLOB_STATE && state_mode)
+		{
+			ByteReader in(p->data, p->length);
+			if (state.Read(in))
+			{
+				if (match_level(state))
+				{
+					state.Apply(Physics::blob, Level::currentLevel);
+					Physics::blob->Update();
+				}
+			}
+			else
 			{
-				hostAddress = sender;
-				const char *host = sender.ToString();
-				rakPeer->Connect(host, REMOTE_GAME_PORT, NULL, 0);
-				connected = true;
-				std::ostringstream ss;
-				ss << "rtmp://" << sender.ToString(false) << "/live/test";
-				break;
+				// Lost our base, ask for a keyframe
+				state.Valid = false;
+				char subscribe = ID_BLOB_STATE_SUBSCRIBE;
+				rakPeer->Send(&subscribe, 1, HIGH_PRIORITY,
+					RELIABLE_ORDERED, STATE_SYNC_CHANNEL, hostAddress, false);
 			}
 		}
-		if (!connected)
-			rakPeer->Ping("255.255.255.255", REMOTE_GAME_PORT, true);
+		rakPeer->DeallocatePacket(p);
 	}
+}
+
+void update()
+{
+	input_display->SetText(convert(input_text) + '_');
+}
+
+void draw()
+{
+	bool connected = rakPeer->GetConnectionState(hostAddress)
+		== RakNet::IS_CONNECTED;
+	if (connected)
+		receive();
 	else
 	{
-		RakNet::ConnectionState connection =
-			rakPeer->GetConnectionState(hostAddress);
-		if (connection != RakNet::IS_CONNECTED)
-		{
+		// Keep trying while playing, in case the first attempt failed or
+		// the connection dropped. join() does nothing while one is pending.
+		if (state_mode || !spectator_mode)
+			join();
+		if (state_mode)
 			return;
-		}
 	}
 
-	if (!spectator_mode)
+	if (!spectator_mode && connected)
 	{
-		char send_data[2];
-		send_data[0] = ID_USER_PACKET_ENUM;
-		send_data[1] = current_input;
-		rakPeer->Send(
-				send_data, 2,
-				IMMEDIATE_PRIORITY, RELIABLE, 0,
-				hostAddress, false);
+		// The server holds our last input, so only send changes and an
+		// occasional heartbeat to keep it alive
+		double now = glfwGetTime();
+		if (current_input != sent_input
+			|| now - last_input_send >= INPUT_HEARTBEAT_INTERVAL)
+		{
+			send_input();
+			sent_input = current_input;
+			last_input_send = now;
+		}
 		if (current_input == NoInput)
 		{
 			if (++timeout >= 30 * 60)
 			{
 				spectator_mode = true;
+				if (!state_mode)
+					leave();
 			}
 		}
 		else
@@ -232,20 +412,11 @@ void draw()
 		}
 	}
 
-	stream->ReceiveFrame(data);
-	glClear(GL_COLOR_BUFFER_BIT);
-	glActiveTexture(GL_TEXTURE0 + tex - 1);
-	glBindTexture(GL_TEXTURE_2D, tex);
-	glTexImage2D(
-			GL_TEXTURE_2D, 0, GL_RGBA,
-			width, height, 0,
-			GL_BGRA, GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stream_program->Use([&](){
-		vao->Bind([](){
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-		});
-	});
+	bool new_frame = false;
+	if (state_mode)
+		draw_state();
+	else
+		new_frame = draw_stream();
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -265,6 +436,101 @@ void draw()
 	}
 
 	glfwSwapBuffers(window);
+
+	if (new_frame && stream->HasFrameID && !spectator_mode && connected)
+	{
+		uint32_t since_input =
+			(uint32_t)((glfwGetTime() - last_input_time) * 1000.0);
+		char send_data[9];
+		send_data[0] = ID_BLOB_FRAME_ACK;
+		memcpy(send_data + 1, &stream->FrameID, 4);
+		memcpy(send_data + 5, &since_input, 4);
+		rakPeer->Send(
+				send_data, 9,
+				HIGH_PRIORITY, UNRELIABLE, 0,
+				hostAddress, false);
+	}
+}
+
+void send_input()
+{
+#ifdef __linux__
+	if (input_socket >= 0)
+	{
+		UdpInputPacket packet = { input_token, ++input_sequence,
+			(uint8_t)current_input };
+		send(input_socket, &packet, sizeof(packet), 0);
+		return;
+	}
+#endif // __linux__
+	char send_data[2];
+	send_data[0] = ID_BLOB_INPUT;
+	send_data[1] = current_input;
+	rakPeer->Send(
+			send_data, 2,
+			IMMEDIATE_PRIORITY, UNRELIABLE_SEQUENCED, INPUT_CHANNEL,
+			hostAddress, false);
+}
+
+bool draw_stream()
+{
+	bool new_frame = stream->ReceiveFrame(data);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	if (new_frame)
+		glTexSubImage2D(
+				GL_TEXTURE_2D, 0, 0, 0,
+				STREAM_WIDTH, STREAM_HEIGHT,
+				GL_BGRA, GL_UNSIGNED_BYTE, data);
+
+	// Edge adaptive upscale to the window, then sharpen
+	glBindFramebuffer(GL_FRAMEBUFFER, upscale_buffer.FBO);
+	glViewport(0, 0, width, height);
+	upscale_program->Use([&](){
+		vao->Bind([](){
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		});
+	});
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glClear(GL_COLOR_BUFFER_BIT);
+	glBindTexture(GL_TEXTURE_2D, upscale_buffer.texture0);
+	stream_program->Use([&](){
+		vao->Bind([](){
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		});
+	});
+	return new_frame;
+}
+
+void draw_state()
+{
+	blobCam->Target = convert(Physics::blob->GetCentroid());
+	blobCam->Update();
+
+	glm::mat4 viewMatrix = blobCam->GetMatrix();
+	glm::mat4 projMatrix = glm::perspective(glm::radians(60.0f),
+		(float)width / (float)height, 0.1f, 500.0f);
+
+	glEnable(GL_DEPTH_TEST);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	renderManager.depthPass(Physics::blob, Level::currentLevel,
+		blobCam->Position);
+	renderManager.dynamicCubeMapPass(Physics::blob, Level::currentLevel);
+
+	glViewport(0, 0, width, height);
+	renderManager.geometryPass(Level::currentLevel, viewMatrix, projMatrix);
+	renderManager.SSAOPass(projMatrix, blobCam->Position);
+	renderManager.blurPass();
+
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glViewport(0, 0, width, height);
+	renderManager.drawBlob(Physics::blob, blobCam->Position,
+		viewMatrix, projMatrix);
+	renderManager.drawLevel(Level::currentLevel, blobCam->Position,
+		viewMatrix, projMatrix);
+	renderManager.drawSkybox(glm::mat4(glm::mat3(viewMatrix)), projMatrix);
+	glDisable(GL_DEPTH_TEST);
 }
 
 std::string convert(std::u32string str)
@@ -290,7 +556,7 @@ void key_callback(
 				int length = send_text.length();
 
 				std::vector<char> send_data(1 + length);
-				send_data[0] = ID_USER_PACKET_ENUM + 1;
+				send_data[0] = ID_BLOB_CHAT;
 				std::copy(send_text.begin(), send_text.end(), send_data.begin() + 1);
 
 				rakPeer->Send(
@@ -328,6 +594,8 @@ void key_callback(
 		if (key == GLFW_KEY_SPACE && action == GLFW_PRESS)
 		{
 			spectator_mode = false;
+			timeout = 0;
+			join();
 		}
 	}
 
@@ -355,6 +623,8 @@ void key_callback(
 			current_input = (BlobInput)(current_input | changed_input);
 		else if (action == GLFW_RELEASE)
 			current_input = (BlobInput)(current_input & ~changed_input);
+		if (action != GLFW_REPEAT)
+			last_input_time = glfwGetTime();
 	}
 }
 
@@ -9,6 +9,8 @@
 #define FontDir RootDir "fonts/"
 #define TextureDir RootDir "textures/"
 #define LevelDir RootDir "levels/"
+// Built BVHs of baked levels, by a hash of their triangles
+#define BakeCacheDir LevelDir "cache/"
 
 #ifdef RTMP_STREAM
 #define STREAM_PROTOCOL "rtmp://"
@@ -28,13 +30,68 @@
 #define STREAM_HEIGHT 720
 #define CLIENT_WIDTH 1366
 #define CLIENT_HEIGHT 768
+#define CLIENT_SHARPNESS 0.2f
 #define TEX_WIDTH 256
 #define TEX_HEIGHT 256
 #define SHADOW_DIM 2048
 #define AO_DIM 720
 #define REMOTE_GAME_PORT 61000
 
+#define NET_INPUT_QUEUE_SIZE 65536
+#define NET_IDLE_SLEEP_MS 1
+#define INPUT_CHANNEL 2
+#define INPUT_HEARTBEAT_INTERVAL 0.2
+#define INPUT_TIMEOUT 1.0
+#define INPUT_SLOTS 16384
+#define UDP_INPUT_PORT_OFFSET 1000
+#define UDP_INPUT_BATCH 64
+#define UDP_INPUT_SOCKET_BUFFER (4 * 1024 * 1024)
+#define INPUT_WINDOW_TICKS 8
+#define INPUT_WINDOW_DECAY 0.8f
+
+#define SERVER_MAX_CONNECTIONS 1024
+#define SERVER_TICK_RATE 60
+#define SIMULATION_TIMESTEP (1.0 / SERVER_TICK_RATE)
+#define MAX_CATCH_UP_TICKS 4
+#define BLOB_NODES 512
+// Each level splits every simulated face in four for rendering only, so
+// a coarse blob can still look smooth
+#define BLOB_RENDER_SUBDIVISIONS 0
+// Including the simulation thread
+#define SOFTBODY_SOLVER_THREADS 4
+// Bodies with fewer links are solved on the simulation thread alone. A
+// solve pays one pool dispatch per colour, which a ~2000 node blob is the
+// first to earn back (bench softbody)
+#define SOFTBODY_PARALLEL_MIN_LINKS 6144
+
+#define DISCOVERY_PORT_RANGE 8
+#define DISCOVERY_WINDOW 0.5
+#define DISCOVERY_MIN_HEADROOM 0.2f
+
+#define CHAT_LOG_LINES 6
+#define CHAT_MAX_LENGTH 64
+#define CHAT_RATE 1.0f
+#define CHAT_BURST 3.0f
+
+#define RELAY_TICK_RATE 60
+#define RELAY_MAX_CONNECTIONS 1000
+
+#define STATE_SYNC_CHANNEL 1
+#define STATE_BLOB_EXTENT 16.0f
+#define STATE_LEVEL_NAME_LENGTH 255
+
+#define LATENCY_FRAME_HISTORY 512
+#define LATENCY_SAMPLES 1024
+#define LATENCY_LOG_INTERVAL 10.0
+
+#define NET_STATS_INTERVAL 1.0
+#define NET_STATS_BUDGET 64
+#define NET_STATS_LOG "netstats.csv"
+#define NET_STATS_CLIENT_LOG "netstats_clients.csv"
+
 #define MAX_PROXIES 32766
+// Room around a level's objects for the blob to fall and for things to move
+#define BROADPHASE_BOUNDS_MARGIN 100.0f
 #define ROTATION_GIZMO_SIZE 15.0f
 
 #define PARTICLE_SIZE 30.0f
@@ -48,6 +105,11 @@
 #define PARTICLE_ZSORT true
 #define PARTICLE_EMIT_RATE 20
 
-#define MOVING_PLATFORM_MASS 9999999
 #define RB_FRICTION 1.0f
+// Sides of a cylinder when it is baked into the level's triangle mesh
+#define BAKE_CYLINDER_SEGMENTS 16
 #define PLATFORM_SPEED_MODIFIER 0.05f
+// Samples per segment when measuring a path, and distance between entries
+// in its baked table
+#define PATH_BAKE_SUBDIVISIONS 16
+#define PATH_TABLE_SPACING 0.1f
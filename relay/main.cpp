@@ -0,0 +1,159 @@
+#include <GLFW/glfw3.h>
+#include <RakNet/MessageIdentifiers.h>
+#include <RakNet/RakPeerInterface.h>
+
+#include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "ChatLog.h"
+#include "InputRelay.h"
+#include "NetworkThread.h"
+#include "HostData.h"
+#include "PacketTypes.h"
+
+#include "config.h"
+
+// Sits between players and the server (or another relay). Player inputs are
+// counted here and forwarded upstream as a single summary per tick, so the
+// server's input cost grows with the number of relays instead of players.
+
+RakNet::RakPeerInterface *rakPeer;
+RakNet::RakNetGUID upstreamGUID = RakNet::UNASSIGNED_RAKNET_GUID;
+const char *upstreamHost;
+unsigned short upstreamPort;
+unsigned short listenPort;
+NetworkThread *network;
+ChatLimiter chat_limiter;
+// Clients joining through the relay watch the upstream server's stream
+char streamEndpoint[64] = "";
+
+void connect_upstream()
+{
+	upstreamGUID = RakNet::UNASSIGNED_RAKNET_GUID;
+	rakPeer->Connect(upstreamHost, upstreamPort, 0, 0);
+	std::cout << "Connecting to " << upstreamHost << ":" << upstreamPort
+		<< std::endl;
+}
+
+void handle_message(const NetMessage& m)
+{
+	switch (m.Type)
+	{
+	case ID_CONNECTION_REQUEST_ACCEPTED:
+		upstreamGUID = m.Client;
+		std::cout << "Connected upstream" << std::endl;
+		break;
+	case ID_CONNECTION_ATTEMPT_FAILED:
+	case ID_NO_FREE_INCOMING_CONNECTIONS:
+		connect_upstream();
+		break;
+	case ID_DISCONNECTION_NOTIFICATION:
+	case ID_CONNECTION_LOST:
+		if (m.Client == upstreamGUID)
+			connect_upstream();
+		else
+			chat_limiter.Remove(m.Client.g);
+		break;
+	case ID_UNCONNECTED_PONG:
+	{
+		const HostData *host = ReadHostData(m.Data.data(), m.Data.size());
+		if (host)
+			memcpy(streamEndpoint, host->StreamEndpoint,
+				sizeof(streamEndpoint));
+		break;
+	}
+	case ID_BLOB_CHAT:
+	case ID_BLOB_RELAYED_CHAT:
+	{
+		if (upstreamGUID == RakNet::UNASSIGNED_RAKNET_GUID
+			|| m.Client == upstreamGUID)
+			break;
+
+		// Upstream only sees the relay, so each player is limited here
+		// and their GUID is carried along for the server's own limit
+		uint64_t origin = m.Client.g;
+		std::size_t text = 1;
+		if (m.Type == ID_BLOB_RELAYED_CHAT)
+		{
+			if (m.Data.size() < 9)
+				break;
+			memcpy(&origin, &m.Data[1], 8);
+			text = 9;
+		}
+		if (!chat_limiter.Allow(origin, m.Time))
+			break;
+
+		std::vector<unsigned char> send_data(9);
+		send_data[0] = ID_BLOB_RELAYED_CHAT;
+		memcpy(&send_data[1], &origin, 8);
+		send_data.insert(send_data.end(), m.Data.begin() + text, m.Data.end());
+		rakPeer->Send((const char *)send_data.data(), send_data.size(),
+			LOW_PRIORITY, RELIABLE, 0, upstreamGUID, false);
+		break;
+	}
+	}
+}
+
+// Answers discovery pings like a server would, with the relay's own load
+void advertise()
+{
+	rakPeer->Ping(upstreamHost, upstreamPort, false);
+
+	HostData data = {};
+	strncpy(data.HostName, "Blobrelay", sizeof(data.HostName) - 1);
+	data.Port[0] = (listenPort >> 8) & 0xFF;
+	data.Port[1] = listenPort & 0xFF;
+	data.Players = (uint16_t)(network->Clients + network->RelayedPlayers);
+	data.Relays = (uint16_t)network->Relays;
+	data.Connections = rakPeer->NumberOfConnections();
+	data.Headroom = 1.f - network->Load;
+	data.NetworkLoad = network->Load;
+	data.DroppedInputs = (uint32_t)network->DroppedInputs;
+	memcpy(data.StreamEndpoint, streamEndpoint, sizeof(data.StreamEndpoint));
+	rakPeer->SetOfflinePingResponse((const char *)&data, sizeof(data));
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		std::cout << "Usage: blobrelay <listen port> <upstream host> "
+			"[upstream port]" << std::endl;
+		return 1;
+	}
+
+	listenPort = (unsigned short)std::atoi(argv[1]);
+	upstreamHost = argv[2];
+	upstreamPort = argc > 3 ? (unsigned short)std::atoi(argv[3])
+		: REMOTE_GAME_PORT;
+
+	// Only used for its timer, which the network thread stamps inputs with
+	glfwInit();
+
+	rakPeer = RakNet::RakPeerInterface::GetInstance();
+	RakNet::SocketDescriptor sd(listenPort, 0);
+	if (rakPeer->Startup(RELAY_MAX_CONNECTIONS + 1, &sd, 1)
+		!= RakNet::RAKNET_STARTED)
+	{
+		std::cout << "Failed to listen on port " << listenPort << std::endl;
+		return 1;
+	}
+	rakPeer->SetMaximumIncomingConnections(RELAY_MAX_CONNECTIONS);
+	connect_upstream();
+
+	network = new NetworkThread(rakPeer);
+	network->Start();
+
+	std::atomic<bool> running{ true };
+	InputRelay relay(rakPeer, network, upstreamGUID, handle_message);
+	relay.Run(running, advertise);
+
+	delete network;
+	rakPeer->Shutdown(0);
+	RakNet::RakPeerInterface::DestroyInstance(rakPeer);
+	glfwTerminate();
+
+	return 0;
+}
@@ -10,12 +10,24 @@
 #include <memory>
 #include <iostream>
 #include <random>
+#include <algorithm>
 
 #include "GLFWProject.h"
 #include "ShaderProgram.h"
 #include "Text.h"
 #include "AggregateInput.h"
+#include "InputWindow.h"
 #include "StreamWriter.h"
+#include "PacketTypes.h"
+#include "LatencyTracker.h"
+#include "StateSync.h"
+#include "NetworkThread.h"
+#include "HostData.h"
+#include "ChatLog.h"
+#include "NetStats.h"
+#include "UdpInputEndpoint.h"
+#include "SimulationThread.h"
+#include "ContactEvents.h"
 
 #include "SoftBody.h"
 #include "Blob.h"
@@ -53,7 +65,11 @@ bool init_physics();
 bool init_graphics();
 bool init_stream();
 void update();
+void tick(SimulationSnapshot& snapshot);
+void capture_stats(SimulationSnapshot& snapshot);
 void draw();
+void sync_state(const SimulationSnapshot& snapshot);
+void advertise();
 
 void infoBox();
 void drawBulletDebug();
@@ -74,6 +90,11 @@ RenderingManager renderManager;
 
 StreamWriter *stream;
 RakNet::RakPeerInterface *rakPeer = RakNet::RakPeerInterface::GetInstance();
+NetworkThread *network;
+#ifdef __linux__
+UdpInputEndpoint *udp_input = nullptr;
+#endif // __linux__
+std::vector<NetMessage> net_messages;
 
 BlobDisplay *blobDisplay;
 float death_plane_y = -100.f;
@@ -81,7 +102,25 @@ float death_plane_y = -100.f;
 ShaderProgram *displayShaderProgram;
 ShaderProgram *debugdrawShaderProgram;
 
+SimulationThread *simulation;
+// Owned by the simulation thread, or whoever holds the world lock
 AggregateInput current_inputs;
+InputWindow input_window;
+InputMagnitudes input_magnitudes;
+// What the last applied snapshot was driven by
+InputMagnitudes displayed_inputs;
+SimulationSnapshot::Figures displayed_stats;
+ContactEvents contact_events;
+
+LatencyTracker latency;
+NetStats net_stats;
+std::vector<InputRate> input_rates;
+uint32_t frame_id = 0;
+
+StateEncoder state_encoder;
+std::vector<RakNet::RakNetGUID> state_viewers;
+std::vector<RakNet::RakNetGUID> new_state_viewers;
+double video_bytes_per_second = 0.0;
 
 LevelEditor *levelEditor;
 Level* Level::currentLevel;
@@ -94,15 +133,26 @@ FlyCam* flyCam;
 BlobCam* blobCam;
 
 std::unique_ptr<Text> chat_text;
+ChatLog chat_log;
+std::string chat_lines;
 std::shared_ptr<Font> chat_font;
 std::unique_ptr<ShaderProgram> text_program;
 
 BulletDebugDrawer_DeprecatedOpenGL bulletDebugDrawer;
 
+// Several servers can share a LAN on different ports and streams
+unsigned short game_port = REMOTE_GAME_PORT;
+std::string stream_endpoint = STREAM_PATH;
+
 #pragma warning(disable:4996)
 
 int main(int argc, char *argv[])
 {
+	if (argc > 1)
+		game_port = (unsigned short)atoi(argv[1]);
+	if (argc > 2)
+		stream_endpoint = argv[2];
+
 	window = GLFWProject::Init("Blobserver", RENDER_WIDTH, RENDER_HEIGHT);
 	if (!window)
 		return 1;
@@ -131,6 +181,9 @@ int main(int argc, char *argv[])
 	
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
+	simulation = new SimulationThread(tick);
+	simulation->Start();
+
 	while (!glfwWindowShouldClose(window))
 	{
 		Profiler::Start("Frame");
@@ -142,23 +195,42 @@ int main(int argc, char *argv[])
 
 		Profiler::Start("Streaming");
 		if (stream->IsOpen())
-			stream->WriteFrame();
+		{
+			latency.FrameCaptured(frame_id, glfwGetTime());
+			if (stream->WriteFrame(frame_id, glfwGetTime()))
+				latency.FrameEncoded(stream->EncodedFrameID, glfwGetTime());
+		}
 		Profiler::Finish("Streaming");
+		latency.Update(glfwGetTime(), std::cout);
+		net_stats.Sample(rakPeer, glfwGetTime(), Timer::deltaTime);
+		advertise();
 
+		// The editor locks the world only for the changes it makes
 		if (bGui)
 		{
 			if (Physics::bShowBulletDebug)
+			{
+				std::lock_guard<std::mutex> lock(Physics::worldMutex);
 				drawBulletDebug();
+			}
 			gui();
 		}
 
 		Profiler::Start("Rendering");
+		Profiler::Start("Swap");
 		glfwSwapBuffers(window);
+		Profiler::Finish("Swap");
 		Profiler::Finish("Rendering", true);
 
 		glfwPollEvents();
 		Profiler::Finish("Frame");
+		frame_id++;
 	}
+	delete simulation;
+#ifdef __linux__
+	delete udp_input;
+#endif // __linux__
+	delete network;
 	if (stream->IsOpen())
 	{
 		rakPeer->Shutdown(0);
@@ -242,106 +314,284 @@ bool init_graphics()
 
 bool init_stream()
 {
-	stream = new StreamWriter(width, height, 1);
+	stream = new StreamWriter(width, height, 1, stream_endpoint);
 
-	RakNet::SocketDescriptor sd(REMOTE_GAME_PORT, 0);
-	rakPeer->Startup(100, &sd, 1);
-	rakPeer->SetMaximumIncomingConnections(100);
+	RakNet::SocketDescriptor sd(game_port, 0);
+	rakPeer->Startup(SERVER_MAX_CONNECTIONS, &sd, 1);
+	rakPeer->SetMaximumIncomingConnections(SERVER_MAX_CONNECTIONS);
+
+	network = new NetworkThread(rakPeer);
+	if (stream->IsOpen())
+	{
+		network->Start();
+#ifdef __linux__
+		udp_input = new UdpInputEndpoint(network);
+		if (!udp_input->Start(game_port + UDP_INPUT_PORT_OFFSET))
+		{
+			delete udp_input;
+			udp_input = nullptr;
+		}
+#endif // __linux__
+	}
 
 	return true;
 }
 
 void update()
 {
-	current_inputs = AggregateInput();
-	while (stream->IsOpen() && rakPeer->GetReceiveBufferSize() > 0)
+	Profiler::Start("Input");
+	network->SwapMessages(net_messages);
+	for (NetMessage& m : net_messages)
 	{
-		RakNet::Packet *p = rakPeer->Receive();
-		unsigned char packet_type = p->data[0];
-		if (packet_type == ID_USER_PACKET_ENUM)
+		if (m.Type == ID_BLOB_INPUT)
 		{
-			BlobInput i = (BlobInput)p->data[1];
-			current_inputs += i;
+			latency.InputReceived(m.Client, (BlobInput)m.Data[1], m.Time);
 		}
-		else if (packet_type == ID_USER_PACKET_ENUM + 1)
+		else if (m.Type == ID_BLOB_CHAT)
 		{
 			std::string text = "Blobchat: ";
-			text.insert(text.end(), p->data + 1, p->data + p->length);
-			chat_text->SetText(text);
+			text.insert(text.end(), m.Data.begin() + 1, m.Data.end());
+			chat_log.Add(m.Client, text, m.Time);
+		}
+		else if (m.Type == ID_BLOB_RELAYED_CHAT && m.Data.size() >= 9)
+		{
+			// Limited by the player who sent it, not the relay
+			uint64_t origin;
+			memcpy(&origin, &m.Data[1], 8);
+			std::string text = "Blobchat: ";
+			text.insert(text.end(), m.Data.begin() + 9, m.Data.end());
+			chat_log.Add(RakNet::RakNetGUID(origin), text, m.Time);
+		}
+		else if (m.Type == ID_BLOB_FRAME_ACK && m.Data.size() >= 9)
+		{
+			uint32_t displayed, since_input;
+			memcpy(&displayed, &m.Data[1], 4);
+			memcpy(&since_input, &m.Data[5], 4);
+			double one_way = rakPeer->GetAveragePing(m.Client) * 0.0005;
+			latency.FrameDisplayed(m.Client, displayed, since_input,
+				m.Time, one_way);
+		}
+		else if (m.Type == ID_NEW_INCOMING_CONNECTION)
+		{
+			net_stats.Connected(m.Client, m.Address);
+#ifdef __linux__
+			if (udp_input)
+			{
+				// Offer the datagram input path
+				uint64_t token = udp_input->AddSession(m.Client);
+				uint16_t port = game_port + UDP_INPUT_PORT_OFFSET;
+				char send_data[11];
+				send_data[0] = ID_BLOB_INPUT_SESSION;
+				memcpy(send_data + 1, &token, 8);
+				memcpy(send_data + 9, &port, 2);
+				rakPeer->Send(send_data, 11, HIGH_PRIORITY, RELIABLE, 0,
+					m.Client, false);
+			}
+#endif // __linux__
+		}
+		else if (m.Type == ID_BLOB_STATE_SUBSCRIBE)
+		{
+			state_viewers.erase(std::remove(state_viewers.begin(),
+				state_viewers.end(), m.Client), state_viewers.end());
+			new_state_viewers.push_back(m.Client);
+		}
+		else if (m.Type == ID_DISCONNECTION_NOTIFICATION
+			|| m.Type == ID_CONNECTION_LOST)
+		{
+			latency.Disconnected(m.Client);
+			chat_log.Disconnected(m.Client);
+			net_stats.Disconnected(m.Client);
+#ifdef __linux__
+			if (udp_input)
+				udp_input->RemoveSession(m.Client);
+#endif // __linux__
+			state_viewers.erase(std::remove(state_viewers.begin(),
+				state_viewers.end(), m.Client), state_viewers.end());
+			new_state_viewers.erase(std::remove(new_state_viewers.begin(),
+				new_state_viewers.end(), m.Client), new_state_viewers.end());
 		}
 	}
 
-	Physics::blob->AddForces(current_inputs);
+	if (network->SwapInputRates(input_rates))
+		net_stats.SetInputRates(input_rates);
+	Profiler::Finish("Input");
+
+	// Rebuild the chat text at most once per frame, growing upwards
+	if (chat_log.TakeText(chat_lines))
+	{
+		chat_text->YPosition = 32 + (chat_log.Count() - 1)
+			* chat_text->LineHeight();
+		chat_text->SetText(chat_lines);
+	}
 
 	Timer::Update(glfwGetTime());
 	Profiler::Update(Timer::deltaTime);
 
-	Profiler::Start("Physics");
-	if(Physics::bStepPhysics)
+	// Respawns asked for by the simulation thread
+	if (Physics::blobRequested)
 	{
-		for(GameObject* ent : Level::currentLevel->Objects)
-		{
-			if (ent->trigger.bEnabled)
-			{
-				bool collides = false;
-				
-				if (!ent->trigger.bDeadly
-					&& !ent->trigger.bLoopy)
-				{
-					Physics::ContactResultCallback callback(&collides);
-					Physics::dynamicsWorld->contactTest
-						(ent->rigidbody, callback);
-				}
-
-				if (Physics::BroadphaseCheck(Physics::blob->softbody,
-					ent->rigidbody))
-					if (Physics::NarrowphaseCheck(Physics::blob->softbody,
-						ent->rigidbody))
-						collides = true;
-
-				if (collides)
-					if (!ent->trigger.bTriggered)
-						ent->trigger.OnEnter();
-					else
-						ent->trigger.OnStay();
-				else
-					if (ent->trigger.bTriggered)
-						ent->trigger.OnLeave();
-			}
-
-			if (ent->motion.Points.size() > 0)
-				ent->rigidbody->setAngularVelocity(btVector3(0, 0, 0));
-				//ent->rigidbody->setAngularFactor(btVector3(0,0,0));
-
-			//if (ent->constrainZ)
-			//{
-			//	/*ent->rigidbody->setLinearVelocity
-			//		(btVector3(ent->rigidbody->getLinearVelocity().getX(),
-			//			ent->rigidbody->getLinearVelocity().getY(),
-			//			0));*/
-			//	ent->rigidbody->setLinearFactor(btVector3(1, 1, 0));
-			//	ent->rigidbody->setAngularFactor(btVector3(1, 0, 0));
-			//}
-		}
-
-		for (GameObject *r : Level::currentLevel->Objects)
-			r->Update(Timer::deltaTime);
-
-		Physics::dynamicsWorld->stepSimulation(Timer::deltaTime, 10);
-		if (Physics::blob->GetCentroid().getY() < death_plane_y)
-			Physics::CreateBlob();
+		std::lock_guard<std::mutex> lock(Physics::worldMutex);
+		Profiler::Start("Respawn");
+		glm::vec4 color;
+		if (Physics::TakeBlobRequest(color))
+			Physics::RespawnBlob(color);
+		Profiler::Finish("Respawn", false, false);
 	}
-	Profiler::Finish("Physics");
+
+	// Draw one tick behind the simulation, between its last two ticks
+	Profiler::Start("Snapshot");
+	const SimulationSnapshot& snapshot = simulation->Latest();
+	float alpha = (float)glm::clamp(
+		(glfwGetTime() - snapshot.Time) / SIMULATION_TIMESTEP, 0.0, 1.0);
+	snapshot.Apply(Physics::blob, Level::currentLevel, alpha);
+	displayed_inputs = snapshot.Inputs;
+	displayed_stats = snapshot.Stats;
+	Profiler::Finish("Snapshot");
 
 	Profiler::Start("Particles");
 	/*for (auto ps : level->ParticleSystems)
 		ps->Update(Timer::deltaTime);*/
 	Profiler::Finish("Particles", false);
 
-	blobCam->Target = convert(Physics::blob->GetCentroid());
+	blobCam->Target = convert(Physics::blob->GetRenderCentroid());
 	activeCam->Update();
 
-	Physics::blob->Update();
+	latency.FrameSimulated(frame_id, snapshot.Time);
+
+	sync_state(snapshot);
+}
+
+// Simulation thread, with the world locked
+void tick(SimulationSnapshot& snapshot)
+{
+	// Catch-up ticks run faster than the network thread counts, so they
+	// reuse the last aggregate rather than vote for nothing
+	network->SwapInputs(current_inputs);
+	input_window.Push(current_inputs);
+	input_magnitudes = input_window.Magnitudes();
+	snapshot.Inputs = input_magnitudes;
+
+	bool step_once = Physics::TakeStepRequest();
+	if (!Physics::bStepPhysics && !step_once)
+	{
+		snapshot.Capture(Physics::blob, Level::currentLevel, false);
+		capture_stats(snapshot);
+		return;
+	}
+
+	Physics::blob->AddForces(input_magnitudes);
+
+	Level::currentLevel->StepPaths();
+	for (GameObject *r : Level::currentLevel->Objects)
+		r->Update();
+
+	Physics::blob->SaveState();
+	for (GameObject *r : Level::currentLevel->Objects)
+		r->SaveTransform();
+
+	Physics::dynamicsWorld->stepSimulation(SIMULATION_TIMESTEP, 0);
+	contact_events.Update(Physics::blob->softbody,
+		Level::currentLevel->Objects);
+	Physics::blob->ComputeCentroid();
+	if (Physics::blob->GetCentroid().getY() < death_plane_y)
+		Physics::RequestBlob();
+
+	snapshot.Capture(Physics::blob, Level::currentLevel, true);
+	capture_stats(snapshot);
+}
+
+// Simulation thread, with the world locked
+void capture_stats(SimulationSnapshot& snapshot)
+{
+	snapshot.Stats.Voting = current_inputs.TotalCount;
+	snapshot.Stats.SolveTime = Physics::softBodySolver->SolveTime;
+	snapshot.Stats.Colours = Physics::softBodySolver->Colours;
+	snapshot.Stats.Touched = contact_events.Touched();
+	snapshot.Stats.Pairs = Physics::broadphase->getOverlappingPairCache()
+		->getNumOverlappingPairs();
+}
+
+void sync_state(const SimulationSnapshot& snapshot)
+{
+	static uint64_t last_video_bytes = 0;
+	static double video_elapsed = 0.0;
+	video_elapsed += Timer::deltaTime;
+	if (video_elapsed >= 1.0)
+	{
+		video_bytes_per_second =
+			(stream->BytesWritten - last_video_bytes) / video_elapsed;
+		last_video_bytes = stream->BytesWritten;
+		video_elapsed = 0.0;
+	}
+
+	state_encoder.Update(Timer::deltaTime);
+	if (state_viewers.empty() && new_state_viewers.empty())
+		return;
+
+	Profiler::Start("State sync");
+	ByteWriter delta, keyframe;
+	state_encoder.Encode(frame_id, snapshot, Level::currentLevel, delta,
+		keyframe, !new_state_viewers.empty());
+
+	// Viewers without a base, or when no delta could be made, get the
+	// full state on the same ordered channel
+	if (delta.Data.empty())
+	{
+		new_state_viewers.insert(new_state_viewers.end(),
+			state_viewers.begin(), state_viewers.end());
+		state_viewers.clear();
+	}
+	for (RakNet::RakNetGUID& viewer : state_viewers)
+		rakPeer->Send((const char *)delta.Data.data(), delta.Data.size(),
+			HIGH_PRIORITY, RELIABLE_ORDERED, STATE_SYNC_CHANNEL,
+			viewer, false);
+
+	for (RakNet::RakNetGUID& viewer : new_state_viewers)
+	{
+		rakPeer->Send((const char *)keyframe.Data.data(),
+			keyframe.Data.size(), HIGH_PRIORITY, RELIABLE_ORDERED,
+			STATE_SYNC_CHANNEL, viewer, false);
+		state_viewers.push_back(viewer);
+	}
+	new_state_viewers.clear();
+	Profiler::Finish("State sync");
+}
+
+// Publishes load figures in the offline ping response, so load generators
+// and clients can read them without connecting
+void advertise()
+{
+	static double last_advert = 0.0;
+	static uint64_t last_input_packets = 0;
+	double now = glfwGetTime();
+	if (now - last_advert < 1.0)
+		return;
+
+	uint64_t input_packets = network->InputPackets;
+	HostData data = {};
+	strncpy(data.HostName, "Blobcast", sizeof(data.HostName) - 1);
+	data.Port[0] = (game_port >> 8) & 0xFF;
+	data.Port[1] = game_port & 0xFF;
+	data.Players = (uint16_t)(network->Clients + network->RelayedPlayers);
+	data.Relays = (uint16_t)network->Relays;
+	data.Connections = rakPeer->NumberOfConnections();
+	// Time spent waiting on vsync is free
+	double work = Profiler::measurements["Frame"].result
+		- Profiler::measurements["Swap"].result;
+	data.Headroom = (float)std::min(1.0 - work * SERVER_TICK_RATE,
+		1.0 - simulation->Load);
+	data.FrameTime = (float)(Profiler::measurements["Frame"].result * 1000.0);
+	data.InputTime = (float)(Profiler::measurements["Input"].result * 1000.0);
+	data.NetworkLoad = network->Load;
+	data.InputPackets = (uint32_t)((input_packets - last_input_packets)
+		/ (now - last_advert));
+	data.DroppedInputs = (uint32_t)network->DroppedInputs;
+	strncpy(data.StreamEndpoint, stream_endpoint.c_str(),
+		sizeof(data.StreamEndpoint) - 1);
+	rakPeer->SetOfflinePingResponse((const char *)&data, sizeof(data));
+
+	last_input_packets = input_packets;
+	last_advert = now;
 }
 
 void draw()
@@ -381,7 +631,7 @@ void draw()
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	blobDisplay->Render(*displayShaderProgram, current_inputs);
+	blobDisplay->Render(*displayShaderProgram, displayed_inputs);
 
 	chat_font->UploadTextureAtlas(0);
 	text_program->Use([&](){
@@ -406,7 +656,10 @@ void gui()
 	if (levelEditor->bShowImguiDemo)
 		ImGui::ShowTestWindow();
 	if (levelEditor->bShowBlobCfg)
+	{
+		std::lock_guard<std::mutex> lock(Physics::worldMutex);
 		Physics::blob->Gui();
+	}
 	
 	if (levelEditor->bShowCameraSettings)
 	{
@@ -468,10 +721,51 @@ void infoBox()
 
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)",
 			1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-		Profiler::Gui("Physics");
+		ImGui::Text("Simulation %.3f ms/tick (%.1f percent) | "
+			"%d caught up | %d dropped", simulation->TickTime.load(),
+			simulation->Load.load() * 100.0f,
+			(int)simulation->CaughtUp.load(), (int)simulation->Dropped.load());
+		ImGui::Text("Soft body solve %.3f ms | %d threads | %d colours",
+			displayed_stats.SolveTime, Physics::softBodySolver->Threads(),
+			displayed_stats.Colours);
+		ImGui::Text("Triggers touched %d | Movers %d | Baked %d%s | "
+			"Broadphase %s, %d pairs", displayed_stats.Touched,
+			Level::currentLevel->MoverCount(),
+			Level::currentLevel->BakedCount(),
+			Level::currentLevel->BakeCached() ? " (cached)" : "",
+			Physics::broadphaseNames[(int)Physics::broadphaseType],
+			displayed_stats.Pairs);
+		Profiler::Gui("Snapshot");
 		Profiler::Gui("Streaming");
 		Profiler::Gui("Rendering");
 		Profiler::Gui("Particles");
+		Profiler::Gui("State sync");
+		Profiler::Gui("Input");
+		Profiler::Gui("Respawn");
+		ImGui::Text("Network thread %.1f percent | %d dropped inputs",
+			network->Load.load() * 100.0f, (int)network->DroppedInputs.load());
+		ImGui::Text("Chat %d throttled | %d dropped",
+			(int)chat_log.Throttled, (int)chat_log.Dropped);
+#ifdef __linux__
+		if (udp_input)
+			ImGui::Text("Datagram inputs %d received | %d rejected",
+				(int)udp_input->Received.load(),
+				(int)udp_input->Rejected.load());
+#endif // __linux__
+		ImGui::Text("Players %d | Relays %d | Voting %d",
+			network->Clients.load(), network->Relays.load(),
+			displayed_stats.Voting);
+		{
+			// Resizing the window under the simulation's Push
+			std::lock_guard<std::mutex> lock(Physics::worldMutex);
+			input_window.Gui();
+		}
+		ImGui::Text("Video %.1f kB/s | State sync %.1f kB/s per viewer (%d)",
+			video_bytes_per_second / 1000.0,
+			state_encoder.BytesPerViewer / 1000.0,
+			(int)state_viewers.size());
+		latency.Gui();
+		net_stats.Gui();
 
 		ImGui::Separator();
 		ImGui::Text("Mouse Position: (%.1f,%.1f)", xcursor, ycursor);
@@ -492,7 +786,7 @@ void key_callback(
 	if (key == GLFW_KEY_G && action == GLFW_PRESS)
 		bGui ^= 1;
 	if (key == GLFW_KEY_F && action == GLFW_PRESS)
-		Physics::dynamicsWorld->stepSimulation(Timer::deltaTime, 10);
+		Physics::RequestStep();
 
 	if (key == GLFW_KEY_DELETE && action == GLFW_PRESS)
 		levelEditor->DeleteSelection();
@@ -502,7 +796,10 @@ void key_callback(
 	else if (key == GLFW_KEY_LEFT_CONTROL && action == GLFW_RELEASE)
 		levelEditor->bCtrl = false;
 
-	Physics::blob->Move(key, action);
+	{
+		std::lock_guard<std::mutex> lock(Physics::worldMutex);
+		Physics::blob->Move(key, action);
+	}
 
 	GLFWProject::WASDStrafe(activeCam, window, key, scancode, action, mods);
 }
@@ -2,9 +2,32 @@
 
 in vec2 vPosition;
 uniform sampler2D uImage;
+uniform float uSharpness;
 out vec4 fColor;
 
+// Robust contrast adaptive sharpening after FSR1 RCAS, applied to the
+// upscaled stream at display resolution. uSharpness is in stops, 0 is
+// the strongest.
+
 void main()
 {
-	fColor = texture(uImage, (vPosition + 1.0) * 0.5);
+	ivec2 p = ivec2(gl_FragCoord.xy);
+	ivec2 size = textureSize(uImage, 0) - 1;
+	vec3 b = texelFetch(uImage, clamp(p + ivec2( 0, -1), ivec2(0), size), 0).rgb;
+	vec3 d = texelFetch(uImage, clamp(p + ivec2(-1,  0), ivec2(0), size), 0).rgb;
+	vec3 e = texelFetch(uImage, clamp(p, ivec2(0), size), 0).rgb;
+	vec3 f = texelFetch(uImage, clamp(p + ivec2( 1,  0), ivec2(0), size), 0).rgb;
+	vec3 h = texelFetch(uImage, clamp(p + ivec2( 0,  1), ivec2(0), size), 0).rgb;
+
+	vec3 mn = min(min(b, d), min(f, h));
+	vec3 mx = max(max(b, d), max(f, h));
+
+	// Largest negative lobe that keeps the result within [0, 1]
+	vec3 hitMin = mn / (4.0 * mx + 1e-5);
+	vec3 hitMax = (1.0 - mx) / (4.0 * mn - 4.0 - 1e-5);
+	vec3 lobes = max(-hitMin, hitMax);
+	float lobe = max(-0.1875, min(max(lobes.r, max(lobes.g, lobes.b)), 0.0))
+		* exp2(-uSharpness);
+
+	fColor = vec4((lobe * (b + d + f + h) + e) / (4.0 * lobe + 1.0), 1.0);
 }
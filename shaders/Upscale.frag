@@ -0,0 +1,103 @@
+#version 330 core
+
+in vec2 vPosition;
+uniform sampler2D uImage;
+out vec4 fColor;
+
+// Edge adaptive upsampling after FSR1 EASU: a 12 tap Lanczos-like kernel
+// rotated onto the local gradient and stretched along the edge.
+//
+//      b c
+//    e f g h
+//    i j k l
+//      n o
+
+vec2 size;
+
+vec3 Tap(vec2 p)
+{
+	return texelFetch(uImage, ivec2(clamp(p, vec2(0.0), size - 1.0)), 0).rgb;
+}
+
+float Luma(vec3 c)
+{
+	return dot(c, vec3(0.299, 0.587, 0.114));
+}
+
+void Accumulate(inout vec3 color, inout float total, vec3 c, vec2 offset,
+		vec2 dir, vec2 stretch, float lobe, float clip)
+{
+	vec2 v = vec2(dot(offset, dir), dot(offset, vec2(-dir.y, dir.x)));
+	v *= stretch;
+	float d2 = min(dot(v, v), clip);
+	float wB = 0.4 * d2 - 1.0;
+	float wA = lobe * d2 - 1.0;
+	wB *= wB;
+	wA *= wA;
+	wB = 1.5625 * wB - 0.5625;
+	float w = wB * wA;
+	color += c * w;
+	total += w;
+}
+
+void main()
+{
+	size = vec2(textureSize(uImage, 0));
+	vec2 pp = (vPosition + 1.0) * 0.5 * size - 0.5;
+	vec2 fp = floor(pp);
+	vec2 pf = pp - fp;
+
+	vec3 b = Tap(fp + vec2( 0, -1)), c = Tap(fp + vec2( 1, -1));
+	vec3 e = Tap(fp + vec2(-1,  0)), f = Tap(fp + vec2( 0,  0));
+	vec3 g = Tap(fp + vec2( 1,  0)), h = Tap(fp + vec2( 2,  0));
+	vec3 i = Tap(fp + vec2(-1,  1)), j = Tap(fp + vec2( 0,  1));
+	vec3 k = Tap(fp + vec2( 1,  1)), l = Tap(fp + vec2( 2,  1));
+	vec3 n = Tap(fp + vec2( 0,  2)), o = Tap(fp + vec2( 1,  2));
+
+	float lb = Luma(b), lc = Luma(c), le = Luma(e), lf = Luma(f);
+	float lg = Luma(g), lh = Luma(h), li = Luma(i), lj = Luma(j);
+	float lk = Luma(k), ll = Luma(l), ln = Luma(n), lo = Luma(o);
+
+	// Gradient at the four inner texels, blended bilinearly
+	vec4 w = vec4((1.0 - pf.x) * (1.0 - pf.y), pf.x * (1.0 - pf.y),
+			(1.0 - pf.x) * pf.y, pf.x * pf.y);
+	vec2 dir =
+		vec2(lg - le, lj - lb) * w.x +
+		vec2(lh - lf, lk - lc) * w.y +
+		vec2(lk - li, ln - lf) * w.z +
+		vec2(ll - lj, lo - lg) * w.w;
+
+	float lmin = min(min(lf, lg), min(lj, lk));
+	float lmax = max(max(lf, lg), max(lj, lk));
+	float len2 = dot(dir, dir);
+	float edge = clamp(0.5 * sqrt(len2) / max(lmax - lmin, 1.0 / 255.0),
+			0.0, 1.0);
+	edge *= edge;
+	dir = (len2 < 1.0 / 32768.0) ? vec2(1.0, 0.0) : dir * inversesqrt(len2);
+
+	// Stretch the kernel along the edge and shorten it across
+	float anisotropy = 1.0 / max(abs(dir.x), abs(dir.y));
+	vec2 stretch = vec2(1.0 + (anisotropy - 1.0) * edge, 1.0 - 0.5 * edge);
+	float lobe = 0.5 - 0.29 * edge;
+	float clip = 1.0 / lobe;
+
+	vec3 color = vec3(0.0);
+	float total = 0.0;
+	Accumulate(color, total, b, vec2( 0, -1) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, c, vec2( 1, -1) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, e, vec2(-1,  0) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, f, vec2( 0,  0) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, g, vec2( 1,  0) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, h, vec2( 2,  0) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, i, vec2(-1,  1) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, j, vec2( 0,  1) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, k, vec2( 1,  1) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, l, vec2( 2,  1) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, n, vec2( 0,  2) - pf, dir, stretch, lobe, clip);
+	Accumulate(color, total, o, vec2( 1,  2) - pf, dir, stretch, lobe, clip);
+
+	// Deringing
+	vec3 cmin = min(min(f, g), min(j, k));
+	vec3 cmax = max(max(f, g), max(j, k));
+	fColor = vec4(clamp(color / total, cmin, cmax), 1.0);
+}
@@ -0,0 +1,447 @@
+#include <RakNet/MessageIdentifiers.h>
+#include <RakNet/RakPeerInterface.h>
+#include <RakNet/RakNetStatistics.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "BlobInput.h"
+#include "HostData.h"
+#include "PacketTypes.h"
+
+#include "config.h"
+
+#ifdef __linux__
+#include "UdpInputEndpoint.h"
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif // __linux__
+
+// Headless load generator. Each bot is its own RakNet peer which behaves
+// like a client: it holds an input from a script or a random pattern,
+// chats now and then and drops and reconnects to simulate churn.
+// Spectator bots only discover the server, like a client watching the
+// stream, until they decide to play.
+
+typedef std::chrono::steady_clock Clock;
+
+struct ScriptStep
+{
+	double Duration;
+	BlobInput Input;
+};
+
+struct Bot
+{
+	RakNet::RakPeerInterface *Peer = nullptr;
+	bool Spectator = false;
+	RakNet::RakNetGUID Server = RakNet::UNASSIGNED_RAKNET_GUID;
+	bool Connecting = false;
+	double ReconnectAt = 0.0;
+
+	BlobInput Input = NoInput;
+	BlobInput SentInput = NoInput;
+	double LastSend = 0.0;
+	double NextChange = 0.0;
+	std::size_t Step = 0;
+
+#ifdef __linux__
+	// Datagram input session, if offered and enabled
+	uint64_t Token = 0;
+	uint16_t Sequence = 0;
+	sockaddr_in InputAddress;
+#endif // __linux__
+};
+
+struct Options
+{
+	const char *Host = "127.0.0.1";
+	unsigned short Port = REMOTE_GAME_PORT;
+	int Peers = 100;
+	int Spectators = 0;
+	// Chance per second that a spectator starts playing
+	double UpgradeRate = 0.0;
+	// Sends per second, or 0 to send on change plus a heartbeat like the
+	// real client
+	double Rate = 0.0;
+	double ChangeInterval = 0.5;
+	double ChatRate = 0.01;
+	double ChurnRate = 0.01;
+	std::string Script;
+	bool Udp = false;
+};
+
+Options options;
+std::vector<ScriptStep> script;
+std::vector<Bot> bots;
+std::mt19937 rng(std::random_device{}());
+uint64_t inputs_sent = 0, chats_sent = 0, disconnects = 0, failures = 0;
+#ifdef __linux__
+int input_socket = -1;
+#endif // __linux__
+
+double now()
+{
+	static Clock::time_point start = Clock::now();
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+double uniform(double a, double b)
+{
+	return std::uniform_real_distribution<double>(a, b)(rng);
+}
+
+// One step per line: "<seconds> <keys>", keys from FBRLJ or - for none
+bool load_script(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file)
+		return false;
+
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream ss(line);
+		ScriptStep step = { 0.0, NoInput };
+		std::string keys;
+		if (!(ss >> step.Duration >> keys))
+			continue;
+		int input = NoInput;
+		for (char c : keys)
+		{
+			if (c == 'F') input |= Forward;
+			else if (c == 'B') input |= Backward;
+			else if (c == 'R') input |= Right;
+			else if (c == 'L') input |= Left;
+			else if (c == 'J') input |= Jump;
+		}
+		step.Input = (BlobInput)input;
+		script.push_back(step);
+	}
+	return !script.empty();
+}
+
+void connect(Bot& bot)
+{
+	bot.Connecting = bot.Peer->Connect(options.Host, options.Port, 0, 0)
+		== RakNet::CONNECTION_ATTEMPT_STARTED;
+	if (!bot.Connecting)
+		bot.ReconnectAt = now() + 1.0;
+}
+
+void next_input(Bot& bot, double time)
+{
+	if (!script.empty())
+	{
+		const ScriptStep& step = script[bot.Step++ % script.size()];
+		bot.Input = step.Input;
+		bot.NextChange = time + step.Duration;
+	}
+	else
+	{
+		bot.Input = (BlobInput)(rng() & 0x1F);
+		bot.NextChange = time + uniform(0.0, 2.0 * options.ChangeInterval);
+	}
+}
+
+void send_input(Bot& bot, double time)
+{
+#ifdef __linux__
+	if (bot.Token != 0)
+	{
+		UdpInputPacket packet = { bot.Token, ++bot.Sequence,
+			(uint8_t)bot.Input };
+		sendto(input_socket, &packet, sizeof(packet), 0,
+			(sockaddr *)&bot.InputAddress, sizeof(bot.InputAddress));
+	}
+	else
+#endif // __linux__
+	{
+		unsigned char data[2] = { ID_BLOB_INPUT, bot.Input };
+		bot.Peer->Send((const char *)data, 2, HIGH_PRIORITY,
+			UNRELIABLE_SEQUENCED, INPUT_CHANNEL, bot.Server, false);
+	}
+	bot.SentInput = bot.Input;
+	bot.LastSend = time;
+	inputs_sent++;
+}
+
+void send_chat(Bot& bot)
+{
+	static const char *lines[] = { "go left", "jump!", "forward", "nooo" };
+	std::string text = lines[rng() % 4];
+	std::vector<char> data(1 + text.size());
+	data[0] = ID_BLOB_CHAT;
+	std::copy(text.begin(), text.end(), data.begin() + 1);
+	bot.Peer->Send(data.data(), data.size(), LOW_PRIORITY, RELIABLE, 0,
+		bot.Server, false);
+	chats_sent++;
+}
+
+bool start_peer(Bot& bot)
+{
+	bot.Peer = RakNet::RakPeerInterface::GetInstance();
+	RakNet::SocketDescriptor sd;
+	return bot.Peer->Startup(1, &sd, 1) == RakNet::RAKNET_STARTED;
+}
+
+void update(Bot& bot, double time, double dt)
+{
+	if (bot.Spectator)
+	{
+		if (uniform(0.0, 1.0) >= options.UpgradeRate * dt)
+			return;
+		bot.Spectator = false;
+		if (!bot.Peer && !start_peer(bot))
+			return;
+		bot.ReconnectAt = time;
+	}
+
+	RakNet::Packet *p;
+	while ((p = bot.Peer->Receive()) != nullptr)
+	{
+		switch (p->data[0])
+		{
+		case ID_CONNECTION_REQUEST_ACCEPTED:
+			bot.Server = p->guid;
+			bot.Connecting = false;
+			bot.LastSend = 0.0;
+#ifdef __linux__
+			bot.Token = 0;
+#endif // __linux__
+			break;
+#ifdef __linux__
+		case ID_BLOB_INPUT_SESSION:
+			if (options.Udp && p->length >= 11)
+			{
+				uint16_t port;
+				memcpy(&bot.Token, p->data + 1, 8);
+				memcpy(&port, p->data + 9, 2);
+				bot.Sequence = 0;
+				bot.InputAddress = {};
+				bot.InputAddress.sin_family = AF_INET;
+				bot.InputAddress.sin_port = htons(port);
+				inet_pton(AF_INET, p->systemAddress.ToString(false),
+					&bot.InputAddress.sin_addr);
+			}
+			break;
+#endif // __linux__
+		case ID_CONNECTION_ATTEMPT_FAILED:
+		case ID_NO_FREE_INCOMING_CONNECTIONS:
+		case ID_DISCONNECTION_NOTIFICATION:
+		case ID_CONNECTION_LOST:
+			failures++;
+			bot.Server = RakNet::UNASSIGNED_RAKNET_GUID;
+			bot.Connecting = false;
+			bot.ReconnectAt = time + uniform(0.5, 2.0);
+			break;
+		}
+		bot.Peer->DeallocatePacket(p);
+	}
+
+	if (bot.Server == RakNet::UNASSIGNED_RAKNET_GUID)
+	{
+		if (!bot.Connecting && time >= bot.ReconnectAt)
+			connect(bot);
+		return;
+	}
+
+	if (uniform(0.0, 1.0) < options.ChurnRate * dt)
+	{
+		bot.Peer->CloseConnection(bot.Server, true);
+		bot.Server = RakNet::UNASSIGNED_RAKNET_GUID;
+		bot.ReconnectAt = time + uniform(0.5, 2.0);
+		disconnects++;
+		return;
+	}
+
+	if (time >= bot.NextChange)
+		next_input(bot, time);
+
+	bool due = options.Rate > 0.0 ?
+		time - bot.LastSend >= 1.0 / options.Rate :
+		bot.Input != bot.SentInput
+			|| time - bot.LastSend >= INPUT_HEARTBEAT_INTERVAL;
+	if (due)
+		send_input(bot, time);
+
+	if (uniform(0.0, 1.0) < options.ChatRate * dt)
+		send_chat(bot);
+}
+
+void report(const HostData *host, double elapsed)
+{
+	static uint64_t last_inputs_sent = 0;
+
+	int connected = 0, spectators = 0;
+	float loss = 0.f;
+	RakNet::RakNetStatistics stats;
+	for (Bot& bot : bots)
+	{
+		spectators += bot.Spectator;
+		if (bot.Server == RakNet::UNASSIGNED_RAKNET_GUID)
+			continue;
+		connected++;
+		if (bot.Peer->GetStatistics(bot.Peer->GetSystemAddressFromGuid(
+				bot.Server), &stats))
+			loss += stats.packetlossLastSecond;
+	}
+	if (connected > 0)
+		loss /= connected;
+
+	double sent_rate = (inputs_sent - last_inputs_sent) / elapsed;
+	last_inputs_sent = inputs_sent;
+
+	std::cout << "bots " << connected << "/" << bots.size()
+		<< " | spectators " << spectators
+		<< " | sent " << (int)sent_rate << " inputs/s"
+		<< " | chat " << chats_sent
+		<< " | churned " << disconnects
+		<< " | failed " << failures
+		<< " | raknet loss " << loss * 100.0f << "%";
+	if (host)
+	{
+		double received = host->InputPackets;
+		std::cout << " || server connections " << host->Connections
+			<< " | players " << host->Players
+			<< " | headroom " << host->Headroom * 100.0f << "%"
+			<< " | received " << host->InputPackets << " inputs/s"
+			<< " | lost " << (sent_rate > 0.0 ?
+				std::max(0.0, 1.0 - received / sent_rate) * 100.0 : 0.0)
+			<< "% | dropped " << host->DroppedInputs
+			<< " | frame " << host->FrameTime << " ms"
+			<< " | input " << host->InputTime << " ms"
+			<< " | network thread " << host->NetworkLoad * 100.0f << "%";
+	}
+	std::cout << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool value = i + 1 < argc;
+		if (arg == "--host" && value) options.Host = argv[++i];
+		else if (arg == "--port" && value)
+			options.Port = (unsigned short)std::atoi(argv[++i]);
+		else if (arg == "--peers" && value) options.Peers = std::atoi(argv[++i]);
+		else if (arg == "--spectators" && value)
+			options.Spectators = std::atoi(argv[++i]);
+		else if (arg == "--upgrade" && value)
+			options.UpgradeRate = std::atof(argv[++i]);
+		else if (arg == "--rate" && value) options.Rate = std::atof(argv[++i]);
+		else if (arg == "--change" && value)
+			options.ChangeInterval = std::atof(argv[++i]);
+		else if (arg == "--chat" && value) options.ChatRate = std::atof(argv[++i]);
+		else if (arg == "--churn" && value)
+			options.ChurnRate = std::atof(argv[++i]);
+		else if (arg == "--script" && value) options.Script = argv[++i];
+		else if (arg == "--udp") options.Udp = true;
+		else
+		{
+			std::cout << "Usage: blobswarm [--host address] [--port port] "
+				"[--peers n] [--spectators n] [--upgrade per second] "
+				"[--rate sends/s] [--change seconds] "
+				"[--chat per second] [--churn per second] "
+				"[--script file] [--udp]" << std::endl;
+			return 1;
+		}
+	}
+
+	if (!options.Script.empty() && !load_script(options.Script))
+	{
+		std::cout << "Failed to load script " << options.Script << std::endl;
+		return 1;
+	}
+
+#ifdef __linux__
+	input_socket = socket(AF_INET, SOCK_DGRAM, 0);
+#endif // __linux__
+
+	RakNet::RakPeerInterface *monitor =
+		RakNet::RakPeerInterface::GetInstance();
+	RakNet::SocketDescriptor sd;
+	monitor->Startup(1, &sd, 1);
+
+	bots.resize(options.Peers + options.Spectators);
+	for (std::size_t i = 0; i < bots.size(); i++)
+	{
+		Bot& bot = bots[i];
+		if (i >= (std::size_t)options.Peers)
+		{
+			// Discovery is all a spectator costs the server
+			bot.Spectator = true;
+			monitor->Ping(options.Host, options.Port, false);
+			continue;
+		}
+		if (!start_peer(bot))
+		{
+			std::cout << "Failed to start peer" << std::endl;
+			return 1;
+		}
+		if (!script.empty())
+			bot.Step = rng() % script.size();
+		// Spread the initial connections over the first second
+		bot.ReconnectAt = uniform(0.0, 1.0);
+	}
+
+	HostData host;
+	bool has_host = false;
+	double last_time = now(), last_report = last_time;
+	while (true)
+	{
+		double time = now();
+		double dt = time - last_time;
+		last_time = time;
+		for (Bot& bot : bots)
+			update(bot, time, dt);
+
+		RakNet::Packet *p;
+		while ((p = monitor->Receive()) != nullptr)
+		{
+			const HostData *data = p->data[0] == ID_UNCONNECTED_PONG ?
+				ReadHostData(p) : nullptr;
+			if (data)
+			{
+				host = *data;
+				has_host = true;
+			}
+			monitor->DeallocatePacket(p);
+		}
+
+		if (time - last_report >= 1.0)
+		{
+			report(has_host ? &host : nullptr, time - last_report);
+			monitor->Ping(options.Host, options.Port, false);
+			last_report = time;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	for (Bot& bot : bots)
+	{
+		if (!bot.Peer)
+			continue;
+		bot.Peer->Shutdown(100);
+		RakNet::RakPeerInterface::DestroyInstance(bot.Peer);
+	}
+	monitor->Shutdown(0);
+	RakNet::RakPeerInterface::DestroyInstance(monitor);
+#ifdef __linux__
+	close(input_socket);
+#endif // __linux__
+
+	return 0;
+}
@@ -0,0 +1,150 @@
+#include "ContactEvents.h"
+#include "GameObject.h"
+#include "ParallelSoftBodySolver.h"
+#include "Physics.h"
+#include "SoftWorld.h"
+
+#include "Test.h"
+#include "config.h"
+
+// Enter, Stay and Leave from ContactEvents' diff of touched triggers. A
+// blob is dropped through a ghost trigger around its top onto a button,
+// and a box drops onto another button. The blob bounces, so rather than
+// fixed counts, each step's events are checked against its raw contacts.
+
+namespace
+{
+	struct Counts
+	{
+		int Enter = 0, Stay = 0, Leave = 0;
+		// Enter only when released, Stay and Leave only when pressed
+		bool Ordered = true;
+
+		bool operator==(const Counts& other) const
+		{
+			return Enter == other.Enter && Stay == other.Stay
+				&& Leave == other.Leave;
+		}
+	};
+
+	GameObject* MakeTrigger(glm::vec3 position, glm::vec3 scale,
+		Counts& counts, float mass = 0.f)
+	{
+		GameObject *ent = new GameObject(nullptr, Shape::Box, position,
+			glm::quat(), scale, glm::vec4(1), 0, mass);
+		ent->trigger.RegisterCallback([&counts, ent]()
+		{
+			counts.Ordered = counts.Ordered && !ent->trigger.bTriggered;
+			counts.Enter++;
+		}, CallbackType::Enter);
+		ent->trigger.RegisterCallback([&counts, ent]()
+		{
+			counts.Ordered = counts.Ordered && ent->trigger.bTriggered;
+			counts.Stay++;
+		}, CallbackType::Stay);
+		ent->trigger.RegisterCallback([&counts, ent]()
+		{
+			counts.Ordered = counts.Ordered && ent->trigger.bTriggered;
+			counts.Leave++;
+		}, CallbackType::Leave);
+		return ent;
+	}
+
+	bool BlobTouches(const btSoftBody *body, const btCollisionObject *obj)
+	{
+		for (int i = 0; i < body->m_rcontacts.size(); i++)
+			if (body->m_rcontacts[i].m_cti.m_colObj == obj)
+				return true;
+		return false;
+	}
+
+	// What the events should add up to, from whether it's touched now
+	void Expect(Counts& expected, bool& was, bool touched)
+	{
+		expected.Enter += touched && !was;
+		expected.Stay += touched && was;
+		expected.Leave += !touched && was;
+		was = touched;
+	}
+
+	void Remove(btSoftRigidDynamicsWorld *world, GameObject *ent)
+	{
+		if (!ent->IsGhost())
+			world->removeRigidBody(ent->rigidbody);
+		delete ent;
+	}
+}
+
+void ContactEventsTest()
+{
+	ParallelSoftBodySolver solver;
+	SoftWorld world(&solver, BLOB_NODES);
+	Physics::dynamicsWorld = world.World;
+
+	// The blob starts with its top at 8 and settles below the ghost
+	Counts ghostCounts, buttonCounts, boxButtonCounts, boxCounts;
+	GameObject *ghost = MakeTrigger(glm::vec3(0, 7.8f, 0),
+		glm::vec3(4, 0.3f, 4), ghostCounts);
+	ghost->SetGhost(true);
+	GameObject *button = MakeTrigger(glm::vec3(0, 1.1f, 0),
+		glm::vec3(1, 0.1f, 1), buttonCounts);
+	// Pressed by a dynamic box rather than the blob. The box is a trigger
+	// too, but only buttons are pressed, by what isn't static.
+	GameObject *boxButton = MakeTrigger(glm::vec3(20, 1.1f, 20),
+		glm::vec3(1, 0.1f, 1), boxButtonCounts);
+	GameObject *box = MakeTrigger(glm::vec3(20, 3, 20), glm::vec3(0.5f),
+		boxCounts, 1.f);
+	std::vector<GameObject *> objects = { ghost, button, boxButton, box };
+
+	ContactEvents events;
+	Counts ghostExpected, buttonExpected;
+	bool ghostWas = false, buttonWas = false;
+	bool matched = true;
+	for (int tick = 0; tick < 240; tick++)
+	{
+		world.Step(1);
+		events.Update(world.Body, objects);
+		Expect(ghostExpected, ghostWas, BlobTouches(world.Body, ghost->ghost));
+		Expect(buttonExpected, buttonWas,
+			BlobTouches(world.Body, button->rigidbody));
+		matched = matched && ghostCounts == ghostExpected
+			&& buttonCounts == buttonExpected;
+		// Touched from the first step, without the blob landing on it
+		if (tick == 0)
+			CHECK(ghostCounts.Enter == 1 && buttonCounts.Enter == 0);
+	}
+	CHECK(matched);
+
+	CHECK(ghostCounts.Stay > 0);
+	CHECK(ghostCounts.Leave > 0);
+	CHECK(!ghost->trigger.bTriggered);
+	CHECK(ghostCounts.Ordered);
+
+	CHECK(buttonCounts.Enter > 0);
+	CHECK(buttonCounts.Stay > 0);
+	CHECK(button->trigger.bTriggered);
+	CHECK(buttonCounts.Ordered);
+
+	// A rigid box settles without bouncing
+	CHECK(boxButtonCounts.Enter == 1);
+	CHECK(boxButtonCounts.Leave == 0);
+	CHECK(boxButtonCounts.Stay > 0);
+	CHECK(boxButton->trigger.bTriggered);
+	CHECK(boxCounts.Enter == 0);
+	CHECK(events.Touched() == 2);
+
+	// Deleting a pressed trigger, as the editor may, raises nothing for it
+	// and leaves the others alone
+	objects.erase(objects.begin() + 1);
+	Remove(world.World, button);
+	int stays = boxButtonCounts.Stay;
+	world.Step(1);
+	events.Update(world.Body, objects);
+	CHECK(buttonCounts.Leave == buttonExpected.Leave);
+	CHECK(boxButtonCounts.Stay == stays + 1);
+	CHECK(events.Touched() == 1);
+
+	for (GameObject *ent : objects)
+		Remove(world.World, ent);
+	Physics::dynamicsWorld = nullptr;
+}
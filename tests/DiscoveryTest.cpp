@@ -0,0 +1,134 @@
+#include <RakNet/RakPeerInterface.h>
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "Discovery.h"
+#include "HostData.h"
+
+#include "Test.h"
+#include "config.h"
+
+// Choosing among adverts, then several servers advertising on consecutive
+// loopback ports, as when they share a LAN. Clients discovering at once
+// should spread over the servers with headroom left, favouring emptier
+// ones, and never join a busy one while another has room.
+
+namespace
+{
+	const unsigned short firstPort = 61200;
+
+	const int picks = 4000;
+
+	struct Advert
+	{
+		uint16_t Players;
+		float Headroom;
+	};
+
+	std::vector<DiscoveredHost> Hosts(const std::vector<Advert>& adverts)
+	{
+		std::vector<DiscoveredHost> hosts(adverts.size());
+		for (std::size_t i = 0; i < adverts.size(); i++)
+		{
+			hosts[i].Data = HostData();
+			hosts[i].Data.Players = adverts[i].Players;
+			hosts[i].Data.Headroom = adverts[i].Headroom;
+		}
+		return hosts;
+	}
+
+	// How often each host is chosen out of picks
+	std::vector<int> Choices(const std::vector<Advert>& adverts)
+	{
+		std::mt19937 rng(1);
+		std::vector<DiscoveredHost> hosts = Hosts(adverts);
+		std::vector<int> counts(hosts.size(), 0);
+		for (int i = 0; i < picks; i++)
+			counts[ChooseHost(hosts, rng)]++;
+		return counts;
+	}
+}
+
+void DiscoveryTest()
+{
+	// Equally loaded hosts are chosen equally often
+	std::vector<int> counts = Choices({ { 5, 0.6f }, { 5, 0.6f },
+		{ 5, 0.6f }, { 5, 0.6f } });
+	for (int count : counts)
+		CHECK(count > picks / 4 * 0.8f && count < picks / 4 * 1.2f);
+
+	// Weighted by one over players plus one, and never the busy host while
+	// another has headroom, however empty it is
+	counts = Choices({ { 0, 0.6f }, { 3, 0.6f }, { 0, 0.05f } });
+	CHECK(counts[2] == 0);
+	CHECK(counts[0] > counts[1] * 3 && counts[0] < counts[1] * 5);
+
+	// With every host busy, the one with most headroom
+	counts = Choices({ { 0, 0.05f }, { 9, 0.15f }, { 2, 0.1f } });
+	CHECK(counts[1] == picks);
+
+	std::mt19937 rng(1);
+	CHECK(ChooseHost({}, rng) == -1);
+
+	// Over loopback: four equally loaded servers and an empty busy one
+	const Advert adverts[] = {
+		{ 5, 0.6f }, { 5, 0.6f }, { 5, 0.6f }, { 5, 0.6f }, { 0, 0.05f }
+	};
+	const int count = sizeof(adverts) / sizeof(adverts[0]);
+	CHECK(count < DISCOVERY_PORT_RANGE);
+
+	std::vector<RakNet::RakPeerInterface*> servers;
+	for (int i = 0; i < count; i++)
+	{
+		RakNet::RakPeerInterface *server =
+			RakNet::RakPeerInterface::GetInstance();
+		RakNet::SocketDescriptor sd(firstPort + i, "127.0.0.1");
+		CHECK(server->Startup(4, &sd, 1) == RakNet::RAKNET_STARTED);
+		server->SetMaximumIncomingConnections(4);
+
+		HostData data = {};
+		strncpy(data.HostName, "Blobtest", sizeof(data.HostName) - 1);
+		data.Port[0] = ((firstPort + i) >> 8) & 0xFF;
+		data.Port[1] = (firstPort + i) & 0xFF;
+		data.Players = adverts[i].Players;
+		data.Headroom = adverts[i].Headroom;
+		server->SetOfflinePingResponse((const char *)&data, sizeof(data));
+		servers.push_back(server);
+	}
+
+	RakNet::RakPeerInterface *client = RakNet::RakPeerInterface::GetInstance();
+	RakNet::SocketDescriptor sd;
+	CHECK(client->Startup(1, &sd, 1) == RakNet::RAKNET_STARTED);
+
+	// Clients discovering in the same second see the same adverts. Eight
+	// all choosing one server of four would happen 1 in 16384 times.
+	std::set<unsigned short> chosen;
+	for (int i = 0; i < 8; i++)
+	{
+		DiscoveredHost found;
+		CHECK(Discover(client, "127.0.0.1", firstPort, found));
+		CHECK(found.Address.GetPort() != firstPort + count - 1);
+		CHECK(found.Data.Players == 5);
+		chosen.insert(found.Address.GetPort());
+	}
+	CHECK(chosen.size() > 1);
+
+	client->Shutdown(0);
+	RakNet::RakPeerInterface::DestroyInstance(client);
+	for (RakNet::RakPeerInterface *server : servers)
+	{
+		server->Shutdown(0);
+		RakNet::RakPeerInterface::DestroyInstance(server);
+	}
+
+	// Nothing listening
+	RakNet::RakPeerInterface *alone = RakNet::RakPeerInterface::GetInstance();
+	CHECK(alone->Startup(1, &sd, 1) == RakNet::RAKNET_STARTED);
+	DiscoveredHost found;
+	CHECK(!Discover(alone, "127.0.0.1", firstPort, found));
+	alone->Shutdown(0);
+	RakNet::RakPeerInterface::DestroyInstance(alone);
+}
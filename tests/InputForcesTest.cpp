@@ -0,0 +1,61 @@
+#include <random>
+#include <vector>
+
+#include "Blob.h"
+#include "PowInputForces.h"
+
+#include "Test.h"
+#include "config.h"
+
+// Blob::InputForces against the pow formulation it replaced, over random
+// offsets, headings and votes, including nodes right on the centroid.
+
+void InputForcesTest()
+{
+	std::mt19937 rng(43);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	std::uniform_real_distribution<float> offset(-3.f, 3.f);
+	const float speed = 3.5f;
+	const int n = 1027;
+
+	for (int trial = 0; trial < 50; trial++)
+	{
+		float angle = unit(rng) * SIMD_2_PI;
+		btVector3 forward(btSin(angle), 0, btCos(angle));
+		InputMagnitudes inputs;
+		float *votes[] = { &inputs.Forward, &inputs.Backward,
+			&inputs.Right, &inputs.Left, &inputs.ForwardRight,
+			&inputs.ForwardLeft, &inputs.BackwardRight, &inputs.BackwardLeft };
+		for (float *vote : votes)
+			*vote = trial % 2 ? unit(rng) : unit(rng) * unit(rng) * 0.25f;
+
+		std::vector<btVector3> offsets(n);
+		std::vector<float> x(n), z(n);
+		for (int i = 0; i < n; i++)
+		{
+			// Every so often exactly on the centroid, or straight along an
+			// axis of the heading, where the dot products are 0 or 1
+			if (i % 97 == 0)
+				offsets[i] = btVector3(0, offset(rng), 0);
+			else if (i % 89 == 0)
+				offsets[i] = forward * offset(rng);
+			else
+				offsets[i] = btVector3(offset(rng), offset(rng), offset(rng));
+			x[i] = offsets[i].x();
+			z[i] = offsets[i].z();
+		}
+
+		Blob::InputForces(x.data(), z.data(), n, forward, inputs, speed);
+
+		int wrong = 0;
+		for (int i = 0; i < n; i++)
+		{
+			btVector3 expected = PowInputForce(offsets[i], forward, inputs,
+				speed);
+			btVector3 actual(x[i], 0, z[i]);
+			if (actual.distance(expected) > 1e-5f * speed)
+				wrong++;
+		}
+		CHECK(wrong == 0);
+	}
+}
@@ -0,0 +1,143 @@
+#include <vector>
+#include <cmath>
+
+#include "GameObject.h"
+#include "PathBatch.h"
+#include "Physics.h"
+
+#include "Test.h"
+#include "config.h"
+
+// Baked paths stepped by PathBatch: platforms move the same distance every
+// tick, on straight and curved paths alike, a lap takes as many ticks as it
+// did when speed counted control points, and a lap covers the whole curve.
+
+namespace
+{
+	// Slow enough that a tick's chord is its arc, even round tight bends
+	const float speed = 0.25f;
+	// Ticks a segment takes on average
+	const int segmentTicks =
+		(int)std::lround(1.f / (PLATFORM_SPEED_MODIFIER * speed));
+
+	GameObject* Mover(const std::vector<glm::vec3>& points, bool curved,
+		bool loop = true)
+	{
+		GameObject *ent = new GameObject(nullptr, Shape::Box, points[0],
+			glm::quat(), glm::vec3(1), glm::vec4(1), 0);
+		ent->motion.Points = points;
+		ent->motion.Curved = curved;
+		ent->motion.Loop = loop;
+		ent->motion.Speed = speed;
+		ent->motion.Enabled = true;
+		ent->UpdateBody();
+		return ent;
+	}
+
+	// The parametric curve's length, sampled far finer than a bake
+	float CurveLength(Path& path)
+	{
+		const int samples = 4096;
+		int segments = (int)path.Points.size() - (path.Loop ? 0 : 1);
+		float length = 0.f;
+		glm::vec3 previous = path.GetPosition(0.f);
+		for (int i = 1; i <= segments * samples; i++)
+		{
+			glm::vec3 p = path.GetPosition((float)i / samples);
+			length += glm::distance(previous, p);
+			previous = p;
+		}
+		return length;
+	}
+
+	// Where each tick of a lap leaves each object, starting from its first
+	// point
+	std::vector<std::vector<glm::vec3>> Run(
+		const std::vector<GameObject *>& objects, int ticks)
+	{
+		PathBatch batch;
+		std::vector<std::vector<glm::vec3>> positions(objects.size());
+		for (std::size_t i = 0; i < objects.size(); i++)
+			positions[i].push_back(objects[i]->motion.Points[0]);
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			batch.Step(objects);
+			for (std::size_t i = 0; i < objects.size(); i++)
+				positions[i].push_back(objects[i]->motion.GetPosition());
+		}
+		return positions;
+	}
+}
+
+void PathTest()
+{
+	Physics::Init();
+	const float side = 4.f;
+	const std::vector<glm::vec3> square = { glm::vec3(0, 0, 0),
+		glm::vec3(side, 0, 0), glm::vec3(side, 0, side),
+		glm::vec3(0, 0, side) };
+	// Segments of very different lengths, which the parametric speed made
+	// the platform rush along and crawl through
+	const std::vector<glm::vec3> oblong = { glm::vec3(0, 0, 0),
+		glm::vec3(8, 0, 0), glm::vec3(8, 0, 3), glm::vec3(0, 0, 3) };
+	std::vector<GameObject *> objects = { Mover(square, false),
+		Mover(square, true), Mover(oblong, true) };
+
+	int lap = 4 * segmentTicks;
+	std::vector<std::vector<glm::vec3>> positions = Run(objects, lap);
+	for (std::size_t i = 0; i < objects.size(); i++)
+	{
+		const std::vector<glm::vec3>& p = positions[i];
+		// Back at the start after a lap
+		CHECK_NEAR(glm::distance(p[lap], p[0]), 0.f, 1e-3f);
+
+		// Every tick the same distance, and a lap the curve's length
+		float total = 0.f, shortest = 1e30f, longest = 0.f;
+		for (int tick = 1; tick <= lap; tick++)
+		{
+			float chord = glm::distance(p[tick - 1], p[tick]);
+			total += chord;
+			shortest = std::min(shortest, chord);
+			longest = std::max(longest, chord);
+		}
+		float length = CurveLength(objects[i]->motion);
+		CHECK_NEAR(total / length, 1.f, 0.01f);
+		CHECK(shortest / longest > 0.97f);
+	}
+
+	// Straight sides are exact: corners fall on ticks, and halfway round
+	// is the opposite corner
+	const std::vector<glm::vec3>& straight = positions[0];
+	for (int tick = 1; tick <= lap; tick++)
+		CHECK_NEAR(glm::distance(straight[tick - 1], straight[tick]),
+			side / segmentTicks, 1e-4f);
+	CHECK_NEAR(glm::distance(straight[segmentTicks / 2],
+		glm::vec3(side / 2, 0, 0)), 0.f, 1e-4f);
+	CHECK_NEAR(glm::distance(straight[lap / 2], square[2]), 0.f, 1e-4f);
+
+	// An open path stops at its end
+	GameObject *open = Mover({ glm::vec3(0, 0, 0), glm::vec3(side, 0, 0),
+		glm::vec3(side, 0, side) }, false, false);
+	std::vector<std::vector<glm::vec3>> end = Run({ open }, 3 * segmentTicks);
+	CHECK_NEAR(glm::distance(end[0][2 * segmentTicks],
+		glm::vec3(side, 0, side)), 0.f, 1e-4f);
+	CHECK_NEAR(glm::distance(end[0].back(), glm::vec3(side, 0, side)),
+		0.f, 1e-4f);
+
+	// A batch picks up a path changed after it was gathered
+	PathBatch batch;
+	batch.Step({ open });
+	open->motion.Points = { glm::vec3(0, 0, side), glm::vec3(side, 0, side) };
+	open->motion.Reset();
+	batch.Step({ open });
+	CHECK_NEAR(glm::distance(open->motion.GetPosition(),
+		glm::vec3(side / segmentTicks, 0, side)), 0.f, 1e-4f);
+	objects.push_back(open);
+
+	for (GameObject *ent : objects)
+	{
+		Physics::dynamicsWorld->removeRigidBody(ent->rigidbody);
+		delete ent;
+	}
+	Physics::Cleanup();
+}
@@ -0,0 +1,81 @@
+#include <BulletSoftBody/btDefaultSoftBodySolver.h>
+
+#include <vector>
+
+#include "ParallelSoftBodySolver.h"
+#include "SoftWorld.h"
+
+#include "Test.h"
+#include "config.h"
+
+// The coloured solver must give the same blob on any thread count, and stay
+// close to Bullet's serial solver, which only differs in link order.
+
+namespace
+{
+	const int ticks = 120;
+
+	std::vector<btVector3> Simulate(btSoftBodySolver *solver, int nodes)
+	{
+		SoftWorld world(solver, nodes);
+		world.Step(ticks);
+		std::vector<btVector3> positions;
+		for (int i = 0; i < world.Body->m_nodes.size(); i++)
+			positions.push_back(world.Body->m_nodes[i].m_x);
+		return positions;
+	}
+
+	btVector3 Centroid(const std::vector<btVector3>& positions)
+	{
+		btVector3 sum(0, 0, 0);
+		for (const btVector3& x : positions)
+			sum += x;
+		return sum / (btScalar)positions.size();
+	}
+
+	// Mean distance of the nodes from their centroid, how squashed it is
+	btScalar Spread(const std::vector<btVector3>& positions)
+	{
+		btVector3 centroid = Centroid(positions);
+		btScalar sum = 0;
+		for (const btVector3& x : positions)
+			sum += x.distance(centroid);
+		return sum / positions.size();
+	}
+}
+
+void SoftBodySolverTest()
+{
+	for (int nodes : { 512, 2048 })
+	{
+		btDefaultSoftBodySolver bullet;
+		std::vector<btVector3> expected = Simulate(&bullet, nodes);
+
+		// Forced parallel, so every colour goes through the pool
+		ParallelSoftBodySolver one(1, 0);
+		std::vector<btVector3> serial = Simulate(&one, nodes);
+		CHECK(serial.size() == expected.size());
+		if (serial.size() != expected.size())
+			continue;
+
+		for (int threads : { 2, 4 })
+		{
+			ParallelSoftBodySolver many(threads, 0);
+			std::vector<btVector3> parallel = Simulate(&many, nodes);
+			bool same = parallel.size() == serial.size();
+			for (size_t i = 0; same && i < serial.size(); i++)
+				same = parallel[i] == serial[i];
+			CHECK(same);
+		}
+
+		// Resting on the floor after a drop from 5. Single nodes in contact
+		// can end up a good way apart, so only the blob as a whole is held
+		// close: where it is, how far nodes moved on average, and its shape
+		CHECK_NEAR(Centroid(serial).distance(Centroid(expected)), 0, 0.05);
+		btScalar moved = 0;
+		for (size_t i = 0; i < serial.size(); i++)
+			moved += serial[i].distance(expected[i]);
+		CHECK_NEAR(moved / serial.size(), 0, 0.15);
+		CHECK_NEAR(Spread(serial) / Spread(expected), 1, 0.02);
+	}
+}
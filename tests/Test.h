@@ -0,0 +1,28 @@
+#pragma once
+
+#include <iostream>
+#include <cmath>
+
+// Failed checks are printed and counted, and the test carries on
+extern int checkFailures;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			checkFailures++; \
+			std::cout << __FILE__ << ":" << __LINE__ << ": CHECK(" \
+				<< #condition << ") failed" << std::endl; \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(a, b, tolerance) CHECK(std::abs((a) - (b)) <= (tolerance))
+
+typedef void (*TestFunc)();
+
+struct Test
+{
+	const char *Name;
+	TestFunc Run;
+};
@@ -0,0 +1,47 @@
+#include "SimulationThread.h"
+
+#include "Test.h"
+#include "config.h"
+
+// The simulation thread's fixed timestep: one tick per interval, late
+// ticks caught up, and long stalls dropped past MAX_CATCH_UP_TICKS.
+
+void TickScheduleTest()
+{
+	typedef TickSchedule::Clock Clock;
+	const Clock::duration interval = std::chrono::milliseconds(10);
+	const Clock::time_point start = Clock::now();
+
+	// On time: the first tick is due immediately, then one per interval
+	TickSchedule schedule(interval, start);
+	CHECK(schedule.Due(start) == 1);
+	CHECK(schedule.Due(start + interval / 2) == 0);
+	CHECK(schedule.Due(start + interval) == 1);
+	CHECK(schedule.Next() == start + interval * 2);
+
+	// A little late: every missed tick is run
+	int late = MAX_CATCH_UP_TICKS - 1;
+	CHECK(schedule.Due(start + interval * (1 + late) + interval / 3)
+		== late);
+	CHECK(schedule.Dropped == 0);
+
+	// A long stall: only MAX_CATCH_UP_TICKS run and the rest are dropped,
+	// leaving the schedule on time again
+	Clock::time_point stall = schedule.Next() + interval * 100;
+	CHECK(schedule.Due(stall) == MAX_CATCH_UP_TICKS);
+	CHECK(schedule.Dropped == (uint64_t)(101 - MAX_CATCH_UP_TICKS));
+	CHECK(schedule.Next() > stall);
+	CHECK(schedule.Due(stall) == 0);
+
+	// Uneven wakeups still average one tick per interval
+	TickSchedule jittered(interval, start);
+	int ticks = 0;
+	Clock::time_point now = start;
+	for (int i = 0; i < 1000; i++)
+	{
+		now += interval * (i % 3) / 2 + std::chrono::microseconds(i % 7);
+		ticks += jittered.Due(now);
+	}
+	CHECK(jittered.Dropped == 0);
+	CHECK(ticks == (int)((now - start) / interval) + 1);
+}
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <cstring>
+
+#include "Test.h"
+
+// Runs every test, or only those named on the command line. Exits non-zero
+// if any check failed.
+
+int checkFailures = 0;
+
+void ContactEventsTest();
+void DiscoveryTest();
+void InputForcesTest();
+void PathTest();
+void SoftBodySolverTest();
+void TickScheduleTest();
+
+const Test tests[] = {
+	{ "contactevents", ContactEventsTest },
+	{ "discovery", DiscoveryTest },
+	{ "inputforces", InputForcesTest },
+	{ "path", PathTest },
+	{ "softbodysolver", SoftBodySolverTest },
+	{ "tickschedule", TickScheduleTest },
+};
+
+int main(int argc, char *argv[])
+{
+	int run = 0;
+	for (const Test& test : tests)
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++)
+			selected = selected || strcmp(argv[i], test.Name) == 0;
+		if (!selected)
+			continue;
+
+		int before = checkFailures;
+		test.Run();
+		std::cout << (checkFailures == before ? "PASS " : "FAIL ")
+			<< test.Name << std::endl;
+		run++;
+	}
+
+	if (run == 0)
+	{
+		std::cout << "No tests matched" << std::endl;
+		return 1;
+	}
+	return checkFailures == 0 ? 0 : 1;
+}